@@ -0,0 +1,458 @@
+#include <atomic>       // For std::atomic
+#include <cstdio>       // For std::printf
+#include <set>          // For std::set
+#include <string>       // For std::string
+#include <string_view>  // For std::string_view
+#include <thread>       // For std::thread
+#include <type_traits>  // For std::is_same
+#include <utility>      // For std::pair
+
+#include "rb_tree.h"
+#include "rb_hash_tree.h"
+#include "rb_buffered_tree.h"
+#include "rb_tree_reclaimer.h"
+#include "rb_static_tree.h"
+#include "rb_sharded_tree.h"
+
+namespace {
+    using int_map = cxx::rb_tree<int, std::pair<const int, int>>;
+
+    int g_failures = 0;
+
+    /// @brief Reports a failed check and remembers it for the exit status.
+    void check(bool _ok, const char *_what) {
+        if (!_ok) {
+            std::printf("FAILED: %s\n", _what);
+            ++g_failures;
+        }
+    }
+
+    /// @brief Returns true if an in-order walk visits strictly increasing keys `0, _step, 2 * _step, ...`.
+    template<typename Tree>
+    bool is_sequence(const Tree &_tree, int _count, int _step) {
+        int _expected = 0;
+        for (auto _it = _tree.begin(); _it != _tree.end(); ++_it) {
+            if (_it->first != _expected) {
+                return false;
+            }
+            _expected += _step;
+        }
+        return _expected == _count * _step;
+    }
+
+    void check_compact() {
+        int_map _tree;
+        const int _count = 10000;
+        // Insert in a scattered order so neighbouring keys live far apart on the heap.
+        for (int _i = 0; _i < _count; ++_i) {
+            _tree.insert({(_i * 7919) % _count, _i});
+        }
+
+        const std::size_t _height = _tree.height();
+        const int_map::compact_stats _stats = _tree.compact();
+        check(_stats.nodes == static_cast<std::size_t>(_count), "compact: node count");
+        check(_stats.span_after == _stats.bytes, "compact: nodes are contiguous");
+        check(_tree.node_span() == _stats.bytes, "compact: node_span() matches");
+        check(_tree.height() == _height, "compact: shape preserved");
+        check(is_sequence(_tree, _count, 1), "compact: order preserved");
+        check((--_tree.end())->first == _count - 1, "compact: --end() reaches the maximum");
+
+        _tree.insert({_count, 0});
+        _tree.compact();
+        check(is_sequence(_tree, _count + 1, 1), "compact: order preserved after recompaction");
+
+        int_map _copy{_tree};
+        _tree.clear();
+        check(_tree.empty() && _tree.compact().nodes == 0, "compact: empty tree");
+        check(is_sequence(_copy, _count + 1, 1), "compact: copy is independent");
+    }
+
+    void check_hash_tree() {
+        cxx::rb_hash_tree<int, std::pair<const int, int>> _map;
+        const int _count = 4096;
+        // Keys stepping by 1024 all share their low bits under the identity std::hash.
+        for (int _i = 0; _i < _count; ++_i) {
+            check(_map.insert({_i * 1024, _i}).second, "hash tree: insert");
+        }
+        check(!_map.insert({0, -1}).second, "hash tree: duplicate rejected");
+        check(_map.size() == static_cast<std::size_t>(_count), "hash tree: size");
+
+        bool _agrees = true;
+        for (int _key = -1024; _key <= _count * 1024; _key += 512) {
+            const auto _it   = _map.find(_key);
+            const auto _node = _map.tree().search({_key, 0});
+            const bool _in_tree = _node != _map.tree().getNil();
+            _agrees = _agrees && (_it != _map.end()) == _in_tree;
+            _agrees = _agrees && (!_in_tree || &*_it == &_node->m_valueField);
+        }
+        check(_agrees, "hash tree: find() agrees with search()");
+        check(is_sequence(_map, _count, 1024), "hash tree: ordered iteration");
+
+        _map.compact();
+        const auto _it = _map.find(1024 * 7);
+        check(_it != _map.end() && _it->second == 7, "hash tree: find() after compact()");
+
+        // Erase every other key; the survivors must stay reachable through the shifted index.
+        for (int _i = 0; _i < _count; _i += 2) {
+            check(_map.erase(_i * 1024) == 1, "hash tree: erase(key)");
+        }
+        check(_map.erase(0) == 0 && _map.erase(1) == 0, "hash tree: erase(key) of a missing key");
+        _agrees = _map.size() == static_cast<std::size_t>(_count / 2);
+        for (int _i = 0; _i < _count; ++_i) {
+            _agrees = _agrees && _map.contains(_i * 1024) == (_i % 2 == 1);
+        }
+        int _expected = 1024;
+        for (auto _pos = _map.begin(); _pos != _map.end(); ++_pos, _expected += 2 * 1024) {
+            _agrees = _agrees && _pos->first == _expected;
+        }
+        check(_agrees && _expected == (_count + 1) * 1024, "hash tree: find() and iteration after erase");
+
+        // Erase through iterators while walking: 1024, 5120, ... go, 3072, 7168, ... stay.
+        for (auto _pos = _map.begin(); _pos != _map.end(); ) {
+            if (_pos->first % 4096 == 1024) {
+                _pos = _map.erase(_pos);
+            } else {
+                ++_pos;
+            }
+        }
+        _agrees   = _map.size() == static_cast<std::size_t>(_count / 4);
+        _expected = 3 * 1024;
+        for (auto _pos = _map.begin(); _pos != _map.end(); ++_pos, _expected += 4 * 1024) {
+            _agrees = _agrees && _pos->first == _expected && _map.find(_expected) == _pos;
+        }
+        check(_agrees && !_map.contains(1024), "hash tree: erase(iterator)");
+
+        for (int _i = 0; _i < _count; ++_i) {
+            _map.insert({_i * 1024, _i});
+        }
+        check(_map.size() == static_cast<std::size_t>(_count), "hash tree: re-insert after erase");
+        check(is_sequence(_map, _count, 1024), "hash tree: iteration after re-insert");
+        _agrees = true;
+        for (int _i = 0; _i < _count; ++_i) {
+            const auto _found = _map.find(_i * 1024);
+            _agrees = _agrees && _found != _map.end() && _found->first == _i * 1024;
+        }
+        check(_agrees, "hash tree: find() after re-insert");
+
+        const auto _copy = _map;
+        _map = _copy;
+        check(_map.find(1024 * 5) != _map.end() && &*_map.find(1024 * 5) != &*_copy.find(1024 * 5),
+              "hash tree: assignment rebuilds the index");
+        _map.clear();
+        check(!_map.contains(0) && _copy.contains(0), "hash tree: copy keeps its own index");
+    }
+
+    void check_buffered_tree() {
+        cxx::rb_buffered_tree<int, std::pair<const int, int>> _map{64};
+        const int _count = 5000;
+        bool _visible = true;
+        for (int _i = 0; _i < _count; ++_i) {
+            const int _key = (_i * 7919) % _count;
+            _map.insert({_key, _i});
+            // A duplicate inserted later must lose to the first one at merge time.
+            _map.insert({_key, -1});
+            _visible = _visible && _map.contains({_key, 0});
+            if (_i % 97 == 0) {
+                const int _old = (_i / 2 * 7919) % _count;
+                const auto *_val = _map.search({_old, 0});
+                _visible = _visible && _val != nullptr && _val->second == _i / 2;
+            }
+        }
+        check(_visible, "buffered tree: search() sees elements across flushes");
+        check(!_map.contains({_count, 0}), "buffered tree: missing key");
+
+        // Half of the buffered entries repeat a key, yet size() counts every key once.
+        const bool _pending = _map.buffered() != 0;
+        check(_pending && _map.size() == static_cast<std::size_t>(_count) && _map.buffered() == 0,
+              "buffered tree: size() drops duplicates");
+        check(is_sequence(_map.tree(), _count, 1), "buffered tree: ordered after flush()");
+
+        _map.insert({_count, 0});
+        auto _copy = _map;
+        check(_copy.contains({_count, 0}) && is_sequence(_copy.tree(), _count + 1, 1),
+              "buffered tree: copy keeps buffered elements");
+
+        // String keys are too large to copy into the buffer and are compared through the nodes.
+        cxx::rb_buffered_tree<std::string, std::pair<const std::string, int>> _names{4};
+        for (const char *_name : {"delta", "alpha", "charlie", "alpha", "bravo", "delta"}) {
+            _names.insert({_name, 0});
+        }
+        check(_names.contains({"charlie", 0}) && _names.size() == 4 && _names.begin()->first == "alpha",
+              "buffered tree: string keys");
+    }
+
+    void check_string_keys() {
+        using string_map = cxx::rb_tree<std::string, std::pair<const std::string, int>>;
+        static_assert(sizeof(string_map::node_type) > sizeof(cxx::rb_tree_node<string_map::value_type>),
+                      "string keys get prefixed nodes");
+
+        // Long shared prefixes, keys shorter than the prefix, embedded '\0' and bytes above 0x7f
+        // all have to order exactly like std::string::compare.
+        std::set<std::string> _expected;
+        string_map _tree;
+        const std::string _stems[] = { "", "a", "ab", std::string("a\0", 2), std::string("a\0b", 3),
+                                       "/usr/local/lib/", "/usr/local/libexec/", "\xff\x80", "zzzzzzzz" };
+        for (const std::string &_stem : _stems) {
+            for (int _i = 0; _i < 200; ++_i) {
+                const std::string _key = _i % 3 == 0 ? _stem : _stem + std::to_string(_i * 37 % 200);
+                _tree.insert({_key, _i});
+                _expected.insert(_key);
+            }
+        }
+        check(_tree.size() == _expected.size(), "string keys: duplicates rejected");
+
+        bool _ordered = true;
+        auto _want = _expected.begin();
+        for (auto _it = _tree.begin(); _it != _tree.end(); ++_it, ++_want) {
+            _ordered = _ordered && _want != _expected.end() && _it->first == *_want;
+        }
+        check(_ordered && _want == _expected.end(), "string keys: order matches std::set");
+
+        bool _found = true;
+        for (const std::string &_key : _expected) {
+            _found = _found && _tree.search({_key, 0}) != _tree.getNil();
+            const bool _extended = _expected.count(_key + '\0') != 0;
+            _found = _found && (_tree.search({_key + '\0', 0}) != _tree.getNil()) == _extended;
+        }
+        check(_found, "string keys: search() finds exactly the inserted keys");
+    }
+
+    /// @brief Mapped type that counts its live instances, to see when nodes are destroyed.
+    struct counted {
+        static std::atomic<int> s_live; // Also changed by the reclaimer thread.
+
+        counted()                { ++s_live; }
+        counted(const counted &) { ++s_live; }
+        ~counted()               { --s_live; }
+    };
+
+    std::atomic<int> counted::s_live{0};
+
+    void check_reclaim() {
+        using counted_map = cxx::rb_tree<int, std::pair<const int, counted>>;
+        const int _count = 20000;
+
+        {
+            counted_map _tree{{}, cxx::rb_tree_reclaim::Incremental};
+            for (int _i = 0; _i < _count; ++_i) {
+                _tree.insert({_i, {}});
+            }
+            _tree.compact();
+            _tree.clear();
+            check(_tree.empty() && _tree.reclaim_pending() && counted::s_live == _count,
+                  "reclaim: incremental clear() only detaches");
+
+            _tree.insert({-1, {}});
+            check(counted::s_live > _count - static_cast<int>(counted_map::reclaim_step),
+                  "reclaim: insert() destroys a bounded number of nodes");
+            check(counted::s_live < _count + 1, "reclaim: insert() makes progress");
+
+            _tree.reclaim(static_cast<std::size_t>(-1));
+            check(!_tree.reclaim_pending() && counted::s_live == 1, "reclaim: reclaim() finishes the work");
+
+            for (int _i = 0; _i < _count; ++_i) {
+                _tree.insert({_i, {}});
+            }
+            _tree.compact();
+            _tree.clear();
+            for (int _i = 0; _i < 100; ++_i) {
+                _tree.insert({_i, {}});
+            }
+            check(_tree.reclaim_pending() && _tree.size() == 100, "reclaim: pending and live nodes");
+        }
+        // The destructor hands the pending and the live nodes to the reclaimer thread.
+        cxx::rb_tree_reclaimer::instance().drain();
+        check(counted::s_live == 0, "reclaim: destructor frees pending nodes");
+
+        {
+            counted_map _tree{{}, cxx::rb_tree_reclaim::Incremental};
+            _tree.insert({0, {}});
+            _tree.clear();
+        }
+        cxx::rb_tree_reclaimer::instance().drain();
+        check(counted::s_live == 0, "reclaim: destructor of an emptied incremental tree");
+
+        {
+            counted_map _tree{{}, cxx::rb_tree_reclaim::Background};
+            for (int _i = 0; _i < _count; ++_i) {
+                _tree.insert({_i, {}});
+            }
+            _tree.clear();
+            _tree.insert({_count, {}});
+            check(_tree.size() == 1 && _tree.begin()->first == _count, "reclaim: tree usable after background clear()");
+
+            counted_map *_other = new counted_map{_tree};
+            for (int _i = 0; _i < _count; ++_i) {
+                _other->insert({_i, {}});
+            }
+            _other->compact();
+            delete _other;
+        }
+        cxx::rb_tree_reclaimer::instance().drain();
+        check(counted::s_live == 0, "reclaim: background thread frees every node");
+    }
+
+    /// @brief Inserts and erases keys under one balancing policy and compares against std::set.
+    template<typename Balance>
+    void check_balance(const char *_what) {
+        cxx::rb_tree<int, std::pair<const int, int>, std::less<int>, Balance> _tree;
+        std::set<int> _expected;
+        bool _agrees = true;
+        for (int _i = 0; _i < 20000; ++_i) {
+            const int _key = (_i * 7919) % 3001;
+            if (_i % 3 == 2) {
+                _agrees = _agrees && _tree.erase({_key, 0}) == _expected.erase(_key);
+            } else {
+                _agrees = _agrees && _tree.insert({_key, _i}).second == _expected.insert(_key).second;
+            }
+        }
+        auto _want = _expected.begin();
+        for (auto _it = _tree.begin(); _it != _tree.end(); ++_it, ++_want) {
+            _agrees = _agrees && _want != _expected.end() && _it->first == *_want;
+        }
+        check(_agrees && _want == _expected.end(), _what);
+
+        // Walk backwards from end(); the sentinel must lead to the maximum after the erases.
+        auto _back = _expected.rbegin();
+        for (auto _it = _tree.end(); _it != _tree.begin(); ++_back) {
+            --_it;
+            _agrees = _agrees && _back != _expected.rend() && _it->first == *_back;
+        }
+        check(_agrees && _back == _expected.rend(), _what);
+
+        // Ascending keys are the worst case for red-black; AVL and weak AVL stay at ~log2(n).
+        decltype(_tree) _ascending;
+        for (int _i = 0; _i < (1 << 16) - 1; ++_i) {
+            _ascending.insert({_i, _i});
+        }
+        const std::size_t _bound = std::is_same<Balance, cxx::rb_tree_red_black>::value ? 32 : 17;
+        check(_ascending.height() <= _bound, _what);
+
+        for (auto _it = _ascending.begin(); _it != _ascending.end(); ) {
+            _it = _ascending.erase(_it);
+        }
+        check(_ascending.empty() && _ascending.begin() == _ascending.end(), _what);
+        _ascending.insert({1, 1});
+        check((--_ascending.end())->first == 1, _what);
+    }
+
+    using opcode_table = cxx::rb_static_tree<std::string_view, std::pair<std::string_view, int>, 8>;
+
+    // Built entirely by the compiler; "add" appears twice and the first entry wins.
+    constexpr opcode_table k_opcodes{{
+        {"mul", 3}, {"add", 1}, {"sub", 2}, {"jmp", 7}, {"add", -1}, {"div", 4}, {"nop", 0}, {"ret", 9}
+    }};
+
+    static_assert(k_opcodes.size() == 7, "static tree: duplicate key dropped");
+    static_assert(k_opcodes.find("add")->second == 1, "static tree: first duplicate wins");
+    static_assert(k_opcodes.find("ret")->second == 9, "static tree: find() at compile time");
+    static_assert(!k_opcodes.contains("xor") && !k_opcodes.contains(""), "static tree: missing keys");
+    static_assert(k_opcodes.height() == 3, "static tree: balanced");
+
+    void check_static_tree() {
+        bool _ordered = true;
+        for (auto _it = k_opcodes.begin(); _it + 1 != k_opcodes.end(); ++_it) {
+            _ordered = _ordered && _it->first < (_it + 1)->first;
+        }
+        check(_ordered, "static tree: iteration in key order");
+
+        bool _found = true;
+        for (const auto &_entry : k_opcodes) {
+            _found = _found && k_opcodes.find(_entry.first) == &_entry;
+        }
+        check(_found, "static tree: find() locates every element");
+
+        constexpr int _keys[] = { 5, 3, 9, 1, 7, 2, 8 };
+        constexpr cxx::rb_static_tree<int, std::pair<int, int>, 7> _squares{{
+            {_keys[0], 25}, {_keys[1], 9}, {_keys[2], 81}, {_keys[3], 1}, {_keys[4], 49}, {_keys[5], 4}, {_keys[6], 64}
+        }};
+        bool _squared = true;
+        for (int _key = 0; _key <= 10; ++_key) {
+            const auto _it = _squares.find(_key);
+            _squared = _squared && (_it == _squares.end() ? !_squares.contains(_key) : _it->second == _key * _key);
+        }
+        check(_squared, "static tree: integer keys");
+    }
+
+    void check_sharded_tree() {
+        using sharded_map = cxx::rb_sharded_tree<int, std::pair<const int, int>>;
+        const int _producers = 4;
+        const int _per_producer = 20000;
+
+        // Each producer pushes its own key range in ascending batches, plus keys another
+        // producer also inserts, so shards are written concurrently and duplicates race.
+        sharded_map _map(8);
+        check(_map.shard_count() == 8, "sharded tree: shard count");
+        std::thread _threads[_producers];
+        for (int _p = 0; _p < _producers; ++_p) {
+            _threads[_p] = std::thread{[&_map, _p] {
+                for (int _i = 0; _i < _per_producer; _i += 4) {
+                    const int _key = _p * _per_producer + _i;
+                    const std::pair<const int, int> _batch[] = {
+                        {_key, _p}, {_key + 1, _p}, {_key + 2, _p}, {_key + 3, _p}
+                    };
+                    _map.insert(_batch, _batch + 4);
+                    _map.insert({(_i * 31) % (_producers * _per_producer), -1});
+                }
+            }};
+        }
+        for (std::thread &_thread : _threads) {
+            _thread.join();
+        }
+
+        const int _count = _producers * _per_producer;
+        check(_map.size() == static_cast<std::size_t>(_count), "sharded tree: every key once");
+        check(is_sequence(_map, _count, 1), "sharded tree: global iteration in key order");
+
+        check(_map.rebalance_count() != 0 && _map.shard_size(0) < static_cast<std::size_t>(_count),
+              "sharded tree: shards rebalanced");
+
+        _map.rebalance();
+        bool _balanced = true;
+        for (std::size_t _i = 0; _i < _map.shard_count(); ++_i) {
+            _balanced = _balanced && _map.shard_size(_i) == static_cast<std::size_t>(_count) / _map.shard_count();
+        }
+        check(_balanced, "sharded tree: rebalance() evens out the shards");
+
+        const auto *_val = _map.search({_count - 1, 0});
+        check(_val != nullptr && _val->second == _producers - 1 && !_map.contains({_count, 0}),
+              "sharded tree: search()");
+
+        sharded_map _split{cxx::rb_sharded_splits, {10, 20}};
+        for (int _key = 25; _key >= 0; _key -= 5) {
+            _split.insert({_key, _key});
+        }
+        check(_split.shard_count() == 3 && _split.shard_size(0) == 2 && _split.shard_size(1) == 2 &&
+              _split.shard_size(2) == 2 && is_sequence(_split, 6, 5), "sharded tree: explicit split points");
+
+        // Ascending keys always land in the last shard; the size has to double between two
+        // automatic rebalances, so there are O(log n) of them instead of one per batch.
+        const int _ascending = 1 << 17;
+        sharded_map _sorted(16);
+        for (int _key = 0; _key < _ascending; ++_key) {
+            _sorted.insert({_key, 0});
+        }
+        check(_sorted.rebalance_count() >= 1 && _sorted.rebalance_count() <= 8 /* log2(2^17 / 1024) + 1 */ &&
+              is_sequence(_sorted, _ascending, 1), "sharded tree: rebalances on ascending input");
+    }
+} // namespace
+
+int main() {
+    check_compact();
+    check_hash_tree();
+    check_buffered_tree();
+    check_string_keys();
+    check_reclaim();
+    check_static_tree();
+    check_balance<cxx::rb_tree_red_black>("balance: red-black");
+    check_balance<cxx::rb_tree_avl>("balance: AVL");
+    check_balance<cxx::rb_tree_wavl>("balance: weak AVL");
+    check_sharded_tree();
+
+    if (g_failures != 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("All checks passed\n");
+    return 0;
+}
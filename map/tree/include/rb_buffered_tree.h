@@ -0,0 +1 @@
+../src/rb_buffered_tree.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/rb_hash_tree.h
\ No newline at end of file
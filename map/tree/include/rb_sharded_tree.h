@@ -0,0 +1 @@
+../src/rb_sharded_tree.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/rb_static_tree.h
\ No newline at end of file
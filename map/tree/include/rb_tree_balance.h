@@ -0,0 +1 @@
+../src/rb_tree_balance.h
\ No newline at end of file
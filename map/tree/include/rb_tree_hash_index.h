@@ -0,0 +1 @@
+../src/rb_tree_hash_index.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/rb_tree_key_prefix.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/rb_tree_reclaimer.h
\ No newline at end of file
@@ -0,0 +1,397 @@
+#ifndef   RB_BUFFERED_TREE_
+# define  RB_BUFFERED_TREE_
+
+# include <bits/c++config.h>     // For std::size_t
+# include <bits/stl_algo.h>      // For std::stable_sort, std::inplace_merge
+# include <bits/stl_function.h>  // For std::less, std::_Select1st
+# include <type_traits>          // For std::is_trivial
+
+# include "rb_tree.h"  // For rb_tree
+
+namespace cxx {
+    /// @brief Write-optimized Red-Black Tree that absorbs insert bursts in a buffer.
+    /// New elements are not linked into the tree right away. Each insert allocates a
+    /// detached node and appends it to a buffer, without descending the tree. The buffer
+    /// is a stack of sorted runs of decreasing length followed by a short unsorted tail;
+    /// a full tail is sorted into a new run and equal-sized runs are merged, like the
+    /// carries of a binary counter. Once the buffer holds as many nodes as the tree it is
+    /// handed to the tree, which links the whole batch in with one linear merge-rebuild
+    /// instead of one descent and fix-up per element (see `rb_tree::_merge_sorted()`).
+    /// Small trivial keys (integers, pointers, ...) are copied into the buffer entries, so sorting and
+    /// merging the buffer compares them without touching the detached nodes.
+    /// Duplicate keys are resolved at merge time: the element inserted first wins, and
+    /// an element already in the tree always wins over a buffered one.
+    /// Lookups check the tree and then the buffer, so they always see every inserted
+    /// element. Ordered iteration and `size()` merge the buffer first.
+    /// @tparam Key The type of keys used for ordering elements.
+    /// @tparam Val The type of elements stored in the container.
+    ///             Typically, a value type like `std::pair<const Key, T>` for associative containers.
+    /// @tparam Compare A binary predicate that defines the ordering of elements. Typically, `std::less<Key>`.
+    template<
+        typename Key,
+        typename Val,
+        typename Compare  = std::less<Key>
+    >
+    class rb_buffered_tree {
+        using _tree_type = rb_tree<Key, Val, Compare>;
+        using _node_type = typename _tree_type::node_type;
+        using _node_ptr  = _node_type *;
+
+    public:
+        using value_type     = Val;
+        using key_type       = Key;
+        using key_compare    = Compare;
+        using size_type      = std::size_t;
+        using iterator       = typename _tree_type::iterator;
+        using compact_stats  = typename _tree_type::compact_stats;
+
+        /// @brief Default lower bound on the number of buffered elements before a merge.
+        static constexpr size_type default_min_buffer = 1024;
+
+        explicit rb_buffered_tree(size_type min_buffer = default_min_buffer,
+                                  const key_compare &comp = key_compare())
+            : m_tree{comp}, m_comp{comp}, m_min_buffer{min_buffer == 0 ? 1 : min_buffer},
+              m_buffer{nullptr}, m_buffer_size{0}, m_buffer_capacity{0}, m_run_end{}, m_run_count{0} {
+        }
+
+        rb_buffered_tree(const rb_buffered_tree &_x)
+            : m_tree{_x.m_tree}, m_comp{_x.m_comp}, m_min_buffer{_x.m_min_buffer},
+              m_buffer{nullptr}, m_buffer_size{0}, m_buffer_capacity{0}, m_run_end{}, m_run_count{0} {
+            _copy_buffer(_x);
+        }
+
+        rb_buffered_tree &operator=(const rb_buffered_tree &_x);
+
+        ~rb_buffered_tree() {
+            _clear_buffer();
+            delete[] m_buffer;
+        }
+
+        /// @brief Returns the number of distinct elements, merging the buffer first.
+        /// Buffered elements may repeat a key, so only the merge can tell how many are new.
+        [[nodiscard]]
+        size_type size() {
+            flush();
+            return m_tree.size();
+        }
+
+        /// @brief Checks if the container is empty.
+        /// @return true if the container holds no elements, false otherwise.
+        [[nodiscard]]
+        constexpr bool empty() const noexcept {
+            return m_tree.empty() && m_buffer_size == 0;
+        }
+
+        /// @brief Returns the number of elements waiting in the buffer, duplicates included.
+        [[nodiscard]]
+        constexpr size_type buffered() const noexcept {
+            return m_buffer_size;
+        }
+
+        /// @brief Returns the underlying Red-Black Tree after merging the buffer into it.
+        [[nodiscard]]
+        const _tree_type &tree() {
+            flush();
+            return m_tree;
+        }
+
+        /// @brief Returns an iterator to the smallest element, merging the buffer first.
+        [[nodiscard]]
+        iterator begin() {
+            flush();
+            return m_tree.begin();
+        }
+
+        /// @brief Returns an iterator to the past-the-end position.
+        [[nodiscard]]
+        iterator end() { return m_tree.end(); }
+
+        /// @brief Appends a value to the buffer, merging the buffer once it is large enough.
+        /// If the key is already present the value is dropped at the next merge.
+        /// @param _val The value to insert.
+        void insert(const value_type &_val);
+
+        /// @brief Searches the tree and then the buffer for the given value.
+        /// Each of the O(log n) runs is binary searched and the short tail is scanned.
+        /// @param _val The value to search for (comparison is done using the key extracted from it).
+        /// @return Pointer to the stored value, or `nullptr` if not found.
+        [[nodiscard]]
+        const value_type *search(const value_type &_val) const;
+
+        /// @brief Checks whether an element with the key of `_val` exists.
+        [[nodiscard]]
+        bool contains(const value_type &_val) const {
+            return search(_val) != nullptr;
+        }
+
+        /// @brief Merges every buffered element into the tree.
+        void flush();
+
+        /// @brief Removes every element from the buffer and the tree.
+        void clear() {
+            _clear_buffer();
+            m_tree.clear();
+        }
+
+        /// @brief Merges the buffer and compacts the underlying tree.
+        /// @see rb_tree::compact()
+        compact_stats compact() {
+            flush();
+            return m_tree.compact();
+        }
+
+    private:
+        /// @brief Extracts the key from a value.
+        static const key_type &_key_of(const value_type &_val) {
+            return std::_Select1st<value_type>()(_val);
+        }
+
+        /// @brief Whether buffer entries carry a copy of the key next to the node pointer.
+        static constexpr bool _cache_key = std::is_trivial<key_type>::value &&
+                                           sizeof(key_type) <= sizeof(void *);
+
+        /// @brief A buffered node together with a copy of its key.
+        template<bool Cached, typename = void>
+        struct _buffer_entry {
+            _node_ptr m_node;
+            key_type  m_key;
+
+            const key_type &key() const noexcept { return m_key; }
+        };
+
+        /// @brief A buffered node whose key is read from the node itself.
+        template<typename Unused>
+        struct _buffer_entry<false, Unused> {
+            _node_ptr m_node;
+
+            const key_type &key() const noexcept { return _key_of(m_node->m_valueField); }
+        };
+
+        using _entry = _buffer_entry<_cache_key>;
+
+        /// @brief Returns the buffer entry for a detached node.
+        static _entry _make_entry(_node_ptr _node) noexcept {
+            if constexpr ( _cache_key ) {
+                return _entry{_node, _key_of(_node->m_valueField)};
+            } else {
+                return _entry{_node};
+            }
+        }
+
+        /// @brief Compares two buffer entries based on their keys.
+        struct _entry_compare {
+            const rb_buffered_tree *m_owner;
+
+            bool operator()(const _entry &_x, const _entry &_y) const {
+                return m_owner->m_comp(_x.key(), _y.key());
+            }
+        };
+
+        /// @brief Returns the buffer size at which `insert()` merges the buffer into the tree.
+        /// Merging once the buffer is as large as the tree makes the O(n) merge-rebuild
+        /// cost O(1) amortized per insert.
+        [[nodiscard]]
+        size_type _flush_threshold() const noexcept {
+            return m_tree.size() > m_min_buffer ? m_tree.size() : m_min_buffer;
+        }
+
+        /// @brief Sorts the tail into a new run and merges runs while the previous one is not longer.
+        /// Both steps are stable, so equal keys keep their insertion order.
+        /// @param _all If true, every run is merged into one regardless of length.
+        void _sort_buffer(bool _all);
+
+        /// @brief Returns the number of buffered nodes that belong to sorted runs.
+        [[nodiscard]]
+        size_type _sorted() const noexcept {
+            return m_run_count == 0 ? 0 : m_run_end[m_run_count - 1];
+        }
+
+        /// @brief Makes room for at least one more buffered node.
+        void _reserve_one();
+
+        /// @brief Appends copies of the buffered nodes of `_x`; the own buffer must be empty.
+        void _copy_buffer(const rb_buffered_tree &_x);
+
+        /// @brief Destroys every buffered node.
+        void _clear_buffer() noexcept;
+
+        /// @brief Length at which the unsorted tail is sorted into a run.
+        static constexpr size_type _tail_limit = 32;
+
+        /// @brief Upper bound on the number of runs; run lengths at least halve from one to the next.
+        static constexpr size_type _max_runs = 8 * sizeof(size_type);
+
+        _tree_type  m_tree;
+        key_compare m_comp;
+        size_type   m_min_buffer;
+        _entry     *m_buffer;              ///< Detached nodes: sorted runs, oldest first, then the tail.
+        size_type   m_buffer_size;
+        size_type   m_buffer_capacity;
+        size_type   m_run_end[_max_runs];  ///< End offset of every run in `m_buffer`.
+        size_type   m_run_count;
+    };
+} // namespace cxx
+
+// Write-buffered Red-Black Tree implementation
+namespace cxx {
+    template<typename Key, typename Val, typename Compare>
+    rb_buffered_tree<Key, Val, Compare> &
+    rb_buffered_tree<Key, Val, Compare>::operator=(const rb_buffered_tree &_x) {
+        if (this == &_x) {
+            return *this;
+        }
+
+        _clear_buffer();
+        m_tree       = _x.m_tree;
+        m_comp       = _x.m_comp;
+        m_min_buffer = _x.m_min_buffer;
+        _copy_buffer(_x);
+        return *this;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::insert(const value_type &_val) {
+        _reserve_one();
+        m_buffer[m_buffer_size] = _make_entry(new _node_type{_val});
+        ++m_buffer_size;
+
+        if (m_buffer_size >= _flush_threshold()) {
+            flush();
+        } else if (m_buffer_size - _sorted() == _tail_limit) {
+            _sort_buffer(false);
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    const Val *rb_buffered_tree<Key, Val, Compare>::search(const value_type &_val) const {
+        const _node_ptr _node = m_tree.search(_val);
+        if (_node != m_tree.getNil()) {
+            return &_node->m_valueField;
+        }
+
+        // Older runs come first, so the first hit is the element inserted first.
+        const key_type &_key = _key_of(_val);
+        size_type _begin = 0;
+        for (size_type _r = 0; _r < m_run_count; ++_r) {
+            size_type _low  = _begin;
+            size_type _high = m_run_end[_r];
+            while (_low < _high) {
+                const size_type _mid = _low + (_high - _low) / 2;
+                if (m_comp(m_buffer[_mid].key(), _key)) {
+                    _low = _mid + 1;
+                } else {
+                    _high = _mid;
+                }
+            }
+            if (_low < m_run_end[_r] && !m_comp(_key, m_buffer[_low].key())) {
+                return &m_buffer[_low].m_node->m_valueField;
+            }
+            _begin = m_run_end[_r];
+        }
+
+        for (size_type _i = _sorted(); _i < m_buffer_size; ++_i) {
+            if (!m_comp(_key, m_buffer[_i].key()) && !m_comp(m_buffer[_i].key(), _key)) {
+                return &m_buffer[_i].m_node->m_valueField;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::flush() {
+        if (m_buffer_size == 0) {
+            return ;
+        }
+
+        _node_ptr *_nodes = new _node_ptr[m_buffer_size];
+        _sort_buffer(true);
+
+        // Keep the first of every run of equal keys; it was inserted first.
+        size_type _unique = 1;
+        _nodes[0] = m_buffer[0].m_node;
+        for (size_type _i = 1; _i < m_buffer_size; ++_i) {
+            if (m_comp(m_buffer[_unique - 1].key(), m_buffer[_i].key())) {
+                m_buffer[_unique] = m_buffer[_i];
+                _nodes[_unique++] = m_buffer[_i].m_node;
+            } else {
+                delete m_buffer[_i].m_node;
+            }
+        }
+        m_buffer_size = _unique;
+        m_run_end[0]  = _unique;
+
+        try {
+            m_tree._merge_sorted(_nodes, m_buffer_size);
+        } catch (...) {
+            delete[] _nodes;
+            throw;
+        }
+        delete[] _nodes;
+        m_buffer_size = 0;
+        m_run_count   = 0;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::_sort_buffer(bool _all) {
+        const _entry_compare _cmp{this};
+        if (_sorted() < m_buffer_size) {
+            std::stable_sort(m_buffer + _sorted(), m_buffer + m_buffer_size, _cmp);
+            m_run_end[m_run_count++] = m_buffer_size;
+        }
+
+        while (m_run_count >= 2) {
+            const size_type _end   = m_run_end[m_run_count - 1];
+            const size_type _mid   = m_run_end[m_run_count - 2];
+            const size_type _begin = m_run_count >= 3 ? m_run_end[m_run_count - 3] : 0;
+            if (!_all && _mid - _begin > _end - _mid) {
+                break;
+            }
+
+            std::inplace_merge(m_buffer + _begin, m_buffer + _mid, m_buffer + _end, _cmp);
+            m_run_end[m_run_count - 2] = _end;
+            --m_run_count;
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::_reserve_one() {
+        if (m_buffer_size < m_buffer_capacity) {
+            return ;
+        }
+
+        const size_type _capacity = m_buffer_capacity == 0 ? m_min_buffer : m_buffer_capacity * 2;
+        _entry *_buffer = new _entry[_capacity];
+        for (size_type _i = 0; _i < m_buffer_size; ++_i) {
+            _buffer[_i] = m_buffer[_i];
+        }
+
+        delete[] m_buffer;
+        m_buffer          = _buffer;
+        m_buffer_capacity = _capacity;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::_copy_buffer(const rb_buffered_tree &_x) {
+        for (size_type _i = 0; _i < _x.m_buffer_size; ++_i) {
+            _reserve_one();
+            m_buffer[m_buffer_size] = _make_entry(new _node_type{_x.m_buffer[_i].m_node->m_valueField});
+            ++m_buffer_size;
+        }
+
+        m_run_count = _x.m_run_count;
+        for (size_type _r = 0; _r < m_run_count; ++_r) {
+            m_run_end[_r] = _x.m_run_end[_r];
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_buffered_tree<Key, Val, Compare>::_clear_buffer() noexcept {
+        for (size_type _i = 0; _i < m_buffer_size; ++_i) {
+            delete m_buffer[_i].m_node;
+        }
+        m_buffer_size = 0;
+        m_run_count   = 0;
+    }
+} // namespace cxx
+
+#endif // RB_BUFFERED_TREE_
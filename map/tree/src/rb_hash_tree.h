@@ -0,0 +1,198 @@
+#ifndef   RB_HASH_TREE_
+# define  RB_HASH_TREE_
+
+# include <bits/c++config.h>        // For std::size_t
+# include <bits/functional_hash.h>  // For std::hash
+# include <bits/stl_function.h>     // For std::less, std::equal_to
+# include <bits/stl_pair.h>         // For std::pair
+
+# include "rb_tree.h"             // For rb_tree
+# include "rb_tree_hash_index.h"  // For rb_tree_hash_index
+
+namespace cxx {
+    /// @brief Ordered container with a hash side-index for exact-key lookups.
+    /// This template class keeps its elements in a Red-Black Tree, so ordered iteration
+    /// behaves exactly as with `rb_tree`, and additionally maintains an open-addressing
+    /// hash index from every key to its tree node. Exact-key lookups go through the index
+    /// in expected O(1) instead of descending the tree in O(log n).
+    /// @tparam Key The type of keys used for ordering and hashing elements.
+    /// @tparam Val The type of elements stored in the container.
+    ///             Typically, a value type like `std::pair<const Key, T>` for associative containers.
+    /// @tparam Compare A binary predicate that defines the ordering of elements. Typically, `std::less<Key>`.
+    /// @tparam Hash A hash function object for `Key`. Typically, `std::hash<Key>`.
+    /// @tparam KeyEqual A binary predicate that checks two keys for equality.
+    ///                  It must agree with `Compare`: equal keys are equivalent and vice versa.
+    template<
+        typename Key,
+        typename Val,
+        typename Compare  = std::less<Key>,
+        typename Hash     = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>
+    >
+    class rb_hash_tree {
+        using _tree_type  = rb_tree<Key, Val, Compare>;
+        using _node_type  = typename _tree_type::node_type;
+        using _index_type = rb_tree_hash_index<Key, Val, Hash, KeyEqual, _node_type>;
+        using _node_ptr   = _node_type *;
+
+    public:
+        using value_type     = Val;
+        using key_type       = Key;
+        using key_compare    = Compare;
+        using hasher         = Hash;
+        using key_equal      = KeyEqual;
+        using size_type      = std::size_t;
+        using iterator       = typename _tree_type::iterator;
+        using const_iterator = typename _tree_type::const_iterator;
+        using compact_stats  = typename _tree_type::compact_stats;
+
+        explicit rb_hash_tree(const key_compare &comp  = key_compare(),
+                              const hasher      &hash  = hasher(),
+                              const key_equal   &equal = key_equal())
+            : m_tree{comp}, m_index{hash, equal} {
+        }
+
+        rb_hash_tree(const rb_hash_tree &_x)
+            : m_tree{_x.m_tree}, m_index{_x.m_index.hash_function(), _x.m_index.key_eq()} {
+            _rebuild_index();
+        }
+
+        /// @brief Replaces the contents with a copy of `_x`.
+        /// The index is emptied before the tree drops its nodes; if copying the tree
+        /// throws, both are left empty rather than the index pointing at freed nodes.
+        rb_hash_tree &operator=(const rb_hash_tree &_x) {
+            if (this == &_x) {
+                return *this;
+            }
+
+            m_index.clear();
+            try {
+                m_tree = _x.m_tree;
+            } catch (...) {
+                m_tree.clear();
+                throw;
+            }
+            _rebuild_index();
+            return *this;
+        }
+
+        /// @brief Returns the number of elements in the container.
+        [[nodiscard]]
+        constexpr size_type size() const {
+            return m_tree.size();
+        }
+
+        /// @brief Checks if the container is empty.
+        /// @return true if the container holds no elements, false otherwise.
+        [[nodiscard]]
+        constexpr bool empty() const noexcept {
+            return m_tree.empty();
+        }
+
+        /// @brief Returns the underlying Red-Black Tree.
+        [[nodiscard]]
+        const _tree_type &tree() const noexcept {
+            return m_tree;
+        }
+
+        [[nodiscard]] iterator       begin()        { return m_tree.begin();  }
+        [[nodiscard]] iterator       end()          { return m_tree.end();    }
+        [[nodiscard]] const_iterator begin()  const { return m_tree.begin();  }
+        [[nodiscard]] const_iterator end()    const { return m_tree.end();    }
+        [[nodiscard]] const_iterator cbegin() const { return m_tree.cbegin(); }
+        [[nodiscard]] const_iterator cend()   const { return m_tree.cend();   }
+
+        /// @brief Inserts a value into the tree and indexes its node.
+        /// The index is grown before the tree is touched, so indexing the new node cannot
+        /// fail and leave an element that `find()` does not see.
+        /// @param _val The value to insert.
+        /// @return A pair consisting of:
+        ///   - an iterator to the inserted element (or to the existing one if insertion failed),
+        ///   - a boolean indicating whether the insertion took place.
+        std::pair<iterator, bool> insert(const value_type &_val) {
+            m_index.reserve(m_tree.size() + 1);
+            std::pair<iterator, bool> _res = m_tree.insert(_val);
+            if (_res.second) {
+                m_index.insert(static_cast<_node_ptr>(_res.first.m_node));
+            }
+            return _res;
+        }
+
+        /// @brief Removes the element with the given key, if there is one.
+        /// The node is found through the index and unindexed before the tree frees it.
+        /// @param _key The key of the element to remove.
+        /// @return The number of elements removed (0 or 1).
+        size_type erase(const key_type &_key) {
+            const _node_ptr _node = m_index.find(_key);
+            if (_node == nullptr) {
+                return 0;
+            }
+
+            m_index.erase(_key);
+            m_tree.erase(iterator{_node, m_tree.getNil()});
+            return 1;
+        }
+
+        /// @brief Removes the element at `_pos`.
+        /// Only iterators to the removed element are invalidated.
+        /// @param _pos Iterator to the element to remove; must be dereferenceable.
+        /// @return Iterator to the element following the removed one.
+        iterator erase(iterator _pos) {
+            m_index.erase(std::_Select1st<value_type>()(*_pos));
+            return m_tree.erase(_pos);
+        }
+
+        /// @brief Looks up an element by key through the hash index.
+        /// @param _key The key to search for.
+        /// @return Iterator to the element with that key, or `end()` if there is none.
+        [[nodiscard]]
+        iterator find(const key_type &_key) {
+            const _node_ptr _node = m_index.find(_key);
+            return _node == nullptr ? end() : iterator{_node, m_tree.getNil()};
+        }
+
+        /// @brief Looks up an element by key through the hash index (const version).
+        /// @param _key The key to search for.
+        /// @return Const iterator to the element with that key, or `end()` if there is none.
+        [[nodiscard]]
+        const_iterator find(const key_type &_key) const {
+            const _node_ptr _node = m_index.find(_key);
+            return _node == nullptr ? end() : const_iterator{_node, m_tree.getNil()};
+        }
+
+        /// @brief Checks whether an element with the given key exists.
+        [[nodiscard]]
+        bool contains(const key_type &_key) const {
+            return m_index.find(_key) != nullptr;
+        }
+
+        /// @brief Removes every element from the tree and the index.
+        void clear() {
+            m_tree.clear();
+            m_index.clear();
+        }
+
+        /// @brief Compacts the underlying tree and re-points the index at the moved nodes.
+        /// @see rb_tree::compact()
+        compact_stats compact() {
+            const compact_stats _stats = m_tree.compact();
+            _rebuild_index();
+            return _stats;
+        }
+
+    private:
+        /// @brief Discards the index and re-adds every node of the tree in order.
+        void _rebuild_index() {
+            m_index.clear();
+            m_index.reserve(m_tree.size());
+            for (iterator _it = m_tree.begin(); _it != m_tree.end(); ++_it) {
+                m_index.insert(static_cast<_node_ptr>(_it.m_node));
+            }
+        }
+
+        _tree_type  m_tree;
+        _index_type m_index;
+    };
+} // namespace cxx
+
+#endif // RB_HASH_TREE_
@@ -0,0 +1,461 @@
+#ifndef   RB_SHARDED_TREE_
+# define  RB_SHARDED_TREE_
+
+# include <bits/c++config.h>                // For std::size_t, std::ptrdiff_t
+# include <bits/stl_function.h>             // For std::less, std::_Select1st
+# include <bits/stl_iterator_base_types.h>  // For std::forward_iterator_tag
+# include <atomic>                          // For std::atomic
+# include <initializer_list>                // For std::initializer_list
+# include <mutex>                           // For std::mutex, std::lock_guard
+# include <new>                             // For ::operator new, ::operator delete
+# include <shared_mutex>                    // For std::shared_mutex, std::shared_lock
+
+# include "rb_tree.h"  // For rb_tree
+
+namespace cxx {
+    /// @brief Tag selecting the `rb_sharded_tree` constructor that takes initial split keys.
+    /// It keeps `rb_sharded_tree<int, ...> _map{8}` meaning eight shards, not one split key.
+    struct rb_sharded_splits_t {
+        explicit rb_sharded_splits_t() = default;
+    };
+
+    /// @brief Tag value for `rb_sharded_tree(rb_sharded_splits_t, ...)`.
+    inline constexpr rb_sharded_splits_t rb_sharded_splits{};
+
+    /// @brief Ordered container split into range partitions that accept writes in parallel.
+    /// This template class divides the key space into `shard_count()` consecutive ranges by
+    /// `shard_count() - 1` split keys. Every range is a shard: a Red-Black Tree with its own
+    /// lock. Shard `i` holds the keys `k` with `split[i - 1] <= k < split[i]`.
+    /// Inserts into different shards do not contend, so write throughput grows with the
+    /// number of shards as long as the producers spread over them. A bulk insert takes a
+    /// shard lock once per run of consecutive elements that fall into the same shard, so
+    /// input that is grouped by shard pays for one lock per group.
+    /// The split keys are a layout guarded by a reader-writer lock: inserts and lookups share
+    /// it, `rebalance()` takes it exclusively. When the largest shard grows past
+    /// `skew_factor` times the average, the inserting thread rebalances the split points
+    /// so that every shard holds about the same number of elements. To keep input that
+    /// always lands in one shard (e.g. ascending keys) from rebalancing over and over, an
+    /// automatic rebalance also waits until the container has grown `rebalance_growth`
+    /// times since the previous one; the O(n) rebalances then cost O(1) amortized per element.
+    /// Iteration walks the shards in sequence and visits all elements in key order. It must
+    /// not run concurrently with inserts.
+    /// @tparam Key The type of keys used for ordering elements. It must be default constructible
+    ///             and copy assignable, since the split keys are stored in an array.
+    /// @tparam Val The type of elements stored in the container.
+    ///             Typically, a value type like `std::pair<const Key, T>` for associative containers.
+    /// @tparam Compare A binary predicate that defines the ordering of elements. Typically, `std::less<Key>`.
+    template<
+        typename Key,
+        typename Val,
+        typename Compare  = std::less<Key>
+    >
+    class rb_sharded_tree {
+        using _tree_type = rb_tree<Key, Val, Compare>;
+        using _node_ptr  = typename _tree_type::node_type *;
+
+        /// @brief One range partition.
+        struct _shard {
+            explicit _shard(const Compare &_comp)
+                : m_tree{_comp} {
+            }
+
+            _tree_type               m_tree;
+            std::mutex               m_mutex;
+            std::atomic<std::size_t> m_size { 0 }; ///< Copy of `m_tree.size()` readable without the lock.
+        };
+
+        template<typename ShardIterator, typename Shard, typename Value>
+        class _iterator;
+
+    public:
+        using value_type     = Val;
+        using key_type       = Key;
+        using key_compare    = Compare;
+        using size_type      = std::size_t;
+        using iterator       = _iterator<typename _tree_type::iterator, _shard, Val>;
+        using const_iterator = _iterator<typename _tree_type::const_iterator, const _shard, const Val>;
+
+        /// @brief The largest shard may hold this many times the average before a rebalance.
+        static constexpr double    skew_factor = 1.5;
+        /// @brief Shards smaller than this never trigger a rebalance.
+        static constexpr size_type min_rebalance_size = 1024;
+        /// @brief Factor by which the size must grow between two automatic rebalances.
+        static constexpr double    rebalance_growth = 2.0;
+
+        /// @brief Creates `shard_count` shards without split points.
+        /// Until the first rebalance every element goes to the first shard; the rebalance
+        /// then derives split points from the data.
+        /// @param shard_count The number of shards; at least one.
+        /// @param comp The comparison object.
+        explicit rb_sharded_tree(size_type shard_count, const key_compare &comp = key_compare())
+            : m_comp{comp}, m_shards{nullptr}, m_shard_count{shard_count == 0 ? 1 : shard_count},
+              m_splits{nullptr}, m_has_splits{false}, m_rebalanced_at{0}, m_rebalances{0} {
+            _allocate();
+        }
+
+        /// @brief Creates one shard more than there are split keys.
+        /// @param splits The initial split keys, in increasing order.
+        /// @param comp The comparison object.
+        rb_sharded_tree(rb_sharded_splits_t, std::initializer_list<key_type> splits,
+                        const key_compare &comp = key_compare())
+            : m_comp{comp}, m_shards{nullptr}, m_shard_count{splits.size() + 1},
+              m_splits{nullptr}, m_has_splits{splits.size() != 0}, m_rebalanced_at{0}, m_rebalances{0} {
+            _allocate();
+            size_type _i = 0;
+            for (const key_type &_split : splits) {
+                m_splits[_i++] = _split;
+            }
+        }
+
+        // The shards hold locks; copying a container that may be written concurrently is not supported.
+        rb_sharded_tree(const rb_sharded_tree &) = delete;
+        rb_sharded_tree &operator=(const rb_sharded_tree &) = delete;
+
+        ~rb_sharded_tree() {
+            _release(m_shard_count);
+        }
+
+        /// @brief Returns the number of elements in all shards.
+        [[nodiscard]]
+        size_type size() const noexcept {
+            size_type _total = 0;
+            for (size_type _i = 0; _i < m_shard_count; ++_i) {
+                _total += m_shards[_i].m_size.load(std::memory_order_relaxed);
+            }
+            return _total;
+        }
+
+        /// @brief Checks if the container is empty.
+        /// @return true if no shard holds an element, false otherwise.
+        [[nodiscard]]
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        /// @brief Returns the number of shards.
+        [[nodiscard]]
+        constexpr size_type shard_count() const noexcept {
+            return m_shard_count;
+        }
+
+        /// @brief Returns how many times the split points have been recomputed so far.
+        [[nodiscard]]
+        size_type rebalance_count() const noexcept {
+            return m_rebalances.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Returns the number of elements in one shard.
+        [[nodiscard]]
+        size_type shard_size(size_type _shard) const noexcept {
+            return m_shards[_shard].m_size.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] iterator       begin()        { return iterator{m_shards, m_shard_count};       }
+        [[nodiscard]] iterator       end()          { return iterator{m_shards, m_shard_count, true}; }
+        [[nodiscard]] const_iterator begin()  const { return cbegin(); }
+        [[nodiscard]] const_iterator end()    const { return cend();   }
+        [[nodiscard]] const_iterator cbegin() const { return const_iterator{m_shards, m_shard_count};       }
+        [[nodiscard]] const_iterator cend()   const { return const_iterator{m_shards, m_shard_count, true}; }
+
+        /// @brief Inserts a value into the shard covering its key. Thread-safe.
+        /// @param _val The value to insert.
+        /// @return `true` if the value was inserted, `false` if its key was already present.
+        bool insert(const value_type &_val) {
+            return insert(&_val, &_val + 1) != 0;
+        }
+
+        /// @brief Inserts a range of values. Thread-safe; producers may call it concurrently.
+        /// Consecutive values that fall into the same shard are inserted under one lock, so
+        /// ranges grouped by shard (e.g. sorted input) cost one lock per group. Values whose
+        /// key is already present are skipped. If the shards end up skewed, the call
+        /// rebalances the split points before returning.
+        /// @param _first The beginning of the range.
+        /// @param _last The end of the range.
+        /// @return The number of values inserted.
+        template<typename InputIt>
+        size_type insert(InputIt _first, InputIt _last);
+
+        /// @brief Searches the shard covering the key of `_val`. Thread-safe.
+        /// @param _val The value to search for (comparison is done using the key extracted from it).
+        /// @return Pointer to the stored value, or `nullptr` if not found. The element may be
+        ///         moved to another shard by a later `rebalance()`, which invalidates the pointer.
+        [[nodiscard]]
+        const value_type *search(const value_type &_val) const;
+
+        /// @brief Checks whether an element with the key of `_val` exists. Thread-safe.
+        [[nodiscard]]
+        bool contains(const value_type &_val) const {
+            return search(_val) != nullptr;
+        }
+
+        /// @brief Moves the split points so that every shard holds about `size() / shard_count()` elements.
+        /// Takes the layout lock exclusively, so it waits for running inserts and blocks new ones.
+        /// The new split keys are read off the global key order. Then every node is detached
+        /// from its shard, without copying its element, and each shard is rebuilt from its
+        /// new slice of the global order in one linear pass (`rb_tree::_link_sorted()`).
+        /// Runs in O(size()). If copying a split key throws, the container is left unchanged.
+        void rebalance();
+
+    private:
+        /// @brief Allocates the shards and the split keys.
+        void _allocate();
+
+        /// @brief Destroys the first `_built` shards and frees the shards and the split keys.
+        void _release(size_type _built) noexcept;
+
+        /// @brief Body of `rebalance()`; requires the layout lock to be held exclusively.
+        void _rebalance();
+
+        /// @brief Extracts the key from a value.
+        static const key_type &_key_of(const value_type &_val) {
+            return std::_Select1st<value_type>()(_val);
+        }
+
+        /// @brief Returns the index of the shard covering `_key`. Requires the layout lock.
+        size_type _route(const key_type &_key) const;
+
+        /// @brief Checks whether an automatic rebalance is due: the largest shard holds more than
+        /// `skew_factor` times the average and the size has grown `rebalance_growth` times since
+        /// the last rebalance.
+        bool _skewed() const noexcept;
+
+        key_compare               m_comp;
+        _shard                   *m_shards;
+        size_type                 m_shard_count;
+        key_type                 *m_splits;        ///< `m_shard_count - 1` split keys in increasing order.
+        bool                      m_has_splits;    ///< Whether `m_splits` has been set; if not, shard 0 takes everything.
+        mutable std::shared_mutex m_layout;        ///< Guards `m_splits`; held exclusively by `rebalance()`.
+        std::atomic<size_type>    m_rebalanced_at; ///< Size at the last rebalance.
+        std::atomic<size_type>    m_rebalances;    ///< Number of rebalances so far.
+    };
+
+    /// @brief Forward iterator visiting every element of every shard in key order.
+    /// Shards are consecutive ranges of the key space, so walking them one after another
+    /// yields the global order.
+    template<typename Key, typename Val, typename Compare>
+    template<typename ShardIterator, typename Shard, typename Value>
+    class rb_sharded_tree<Key, Val, Compare>::_iterator {
+        friend class rb_sharded_tree;
+
+    public:
+        using value_type = Val;
+        using reference  = Value &;
+        using pointer    = Value *;
+
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+
+        reference operator*()  const { return *m_it;     }
+        pointer   operator->() const { return &*m_it;    }
+
+        _iterator &operator++() {
+            ++m_it;
+            _skip_empty();
+            return *this;
+        }
+
+        _iterator operator++(int) {
+            _iterator _tmp = *this;
+            ++*this;
+            return _tmp;
+        }
+
+        [[nodiscard]] bool
+        operator==(const _iterator &_x) const { return m_shard == _x.m_shard && m_it == _x.m_it; }
+
+        [[nodiscard]] bool
+        operator!=(const _iterator &_x) const { return !(*this == _x); }
+
+    private:
+        /// @brief Positions the iterator on the first element, or at the end if `_end` is set.
+        _iterator(Shard *_shards, std::size_t _count, bool _end = false)
+            : m_shards{_shards}, m_count{_count}, m_shard{_end ? _count - 1 : 0},
+              m_it{_end ? _shards[_count - 1].m_tree.end() : _shards[0].m_tree.begin()} {
+            _skip_empty();
+        }
+
+        /// @brief Moves past the end of exhausted shards, stopping at the end of the last one.
+        void _skip_empty() {
+            while (m_shard + 1 < m_count && m_it == m_shards[m_shard].m_tree.end()) {
+                ++m_shard;
+                m_it = m_shards[m_shard].m_tree.begin();
+            }
+        }
+
+        Shard        *m_shards;
+        std::size_t   m_count;
+        std::size_t   m_shard;
+        ShardIterator m_it;
+    };
+} // namespace cxx
+
+// Sharded tree implementation
+namespace cxx {
+    template<typename Key, typename Val, typename Compare>
+    template<typename InputIt>
+    typename rb_sharded_tree<Key, Val, Compare>::size_type
+    rb_sharded_tree<Key, Val, Compare>::insert(InputIt _first, InputIt _last) {
+        size_type _inserted = 0;
+        {
+            std::shared_lock<std::shared_mutex> _layout{m_layout};
+            while (_first != _last) {
+                const size_type _index = _route(_key_of(*_first));
+                _shard &_target = m_shards[_index];
+
+                std::lock_guard<std::mutex> _lock{_target.m_mutex};
+                do {
+                    _inserted += _target.m_tree.insert(*_first).second ? 1 : 0;
+                    ++_first;
+                } while (_first != _last && _route(_key_of(*_first)) == _index);
+                _target.m_size.store(_target.m_tree.size(), std::memory_order_relaxed);
+            }
+        }
+
+        if (_skewed()) {
+            std::unique_lock<std::shared_mutex> _layout{m_layout};
+            // Another producer may have rebalanced while this one waited for the lock.
+            if (_skewed()) {
+                _rebalance();
+            }
+        }
+        return _inserted;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    const typename rb_sharded_tree<Key, Val, Compare>::value_type *
+    rb_sharded_tree<Key, Val, Compare>::search(const value_type &_val) const {
+        std::shared_lock<std::shared_mutex> _layout{m_layout};
+        _shard &_target = m_shards[_route(_key_of(_val))];
+
+        std::lock_guard<std::mutex> _lock{_target.m_mutex};
+        const auto _node = _target.m_tree.search(_val);
+        return _node == _target.m_tree.getNil() ? nullptr : &_node->m_valueField;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_sharded_tree<Key, Val, Compare>::rebalance() {
+        std::unique_lock<std::shared_mutex> _layout{m_layout};
+        _rebalance();
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_sharded_tree<Key, Val, Compare>::_rebalance() {
+        if (m_shard_count == 1) {
+            return ;
+        }
+
+        // Every writer is locked out, so the shards can be read and relinked freely.
+        size_type _total = 0;
+        for (size_type _i = 0; _i < m_shard_count; ++_i) {
+            _total += m_shards[_i].m_tree.size();
+        }
+        if (_total == 0) {
+            return ;
+        }
+
+        // Shard i gets the elements of global rank [_total * i / n, _total * (i + 1) / n),
+        // so split i is the key of rank _total * (i + 1) / n. Everything that can throw
+        // happens before the first node is detached.
+        _node_ptr *_nodes  = new _node_ptr[_total];
+        key_type  *_splits = nullptr;
+        try {
+            _splits = new key_type[m_shard_count - 1];
+            size_type _rank  = 0;
+            size_type _split = 0;
+            for (iterator _it = begin(); _it != end() && _split + 1 < m_shard_count; ++_it, ++_rank) {
+                while (_split + 1 < m_shard_count && _rank == _total * (_split + 1) / m_shard_count) {
+                    _splits[_split++] = _key_of(*_it);
+                }
+            }
+        } catch (...) {
+            delete[] _splits;
+            delete[] _nodes;
+            throw;
+        }
+
+        // The shards are consecutive ranges, so detaching them in turn yields the global order.
+        size_type _taken = 0;
+        for (size_type _i = 0; _i < m_shard_count; ++_i) {
+            _tree_type &_tree = m_shards[_i].m_tree;
+            const size_type _size = _tree.size();
+            _tree._take_nodes(_nodes + _taken);
+            _taken += _size;
+        }
+        for (size_type _i = 0; _i < m_shard_count; ++_i) {
+            const size_type _begin = _total * _i / m_shard_count;
+            const size_type _end   = _total * (_i + 1) / m_shard_count;
+            m_shards[_i].m_tree._link_sorted(_nodes + _begin, _end - _begin);
+            m_shards[_i].m_size.store(_end - _begin, std::memory_order_relaxed);
+        }
+        delete[] _nodes;
+
+        delete[] m_splits;
+        m_splits     = _splits;
+        m_has_splits = true;
+        m_rebalanced_at.store(_total, std::memory_order_relaxed);
+        m_rebalances.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_sharded_tree<Key, Val, Compare>::_allocate() {
+        m_shards = static_cast<_shard *>(::operator new(m_shard_count * sizeof(_shard)));
+        size_type _built = 0;
+        try {
+            for (; _built < m_shard_count; ++_built) {
+                ::new (static_cast<void *>(m_shards + _built)) _shard{m_comp};
+            }
+            m_splits = new key_type[m_shard_count - 1];
+        } catch (...) {
+            _release(_built);
+            throw;
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    void rb_sharded_tree<Key, Val, Compare>::_release(size_type _built) noexcept {
+        while (_built > 0) {
+            m_shards[--_built].~_shard();
+        }
+        ::operator delete(m_shards);
+        delete[] m_splits;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    typename rb_sharded_tree<Key, Val, Compare>::size_type
+    rb_sharded_tree<Key, Val, Compare>::_route(const key_type &_key) const {
+        if (!m_has_splits) {
+            return 0;
+        }
+
+        // Number of split keys <= _key, i.e. upper_bound over m_splits.
+        size_type _low  = 0;
+        size_type _high = m_shard_count - 1;
+        while (_low < _high) {
+            const size_type _mid = _low + (_high - _low) / 2;
+            if (m_comp(_key, m_splits[_mid])) {
+                _high = _mid;
+            } else {
+                _low = _mid + 1;
+            }
+        }
+        return _low;
+    }
+
+    template<typename Key, typename Val, typename Compare>
+    bool rb_sharded_tree<Key, Val, Compare>::_skewed() const noexcept {
+        size_type _total   = 0;
+        size_type _largest = 0;
+        for (size_type _i = 0; _i < m_shard_count; ++_i) {
+            const size_type _size = m_shards[_i].m_size.load(std::memory_order_relaxed);
+            _total  += _size;
+            _largest = _size > _largest ? _size : _largest;
+        }
+        return m_shard_count > 1 && _largest >= min_rebalance_size &&
+               static_cast<double>(_largest) * static_cast<double>(m_shard_count) >
+               skew_factor * static_cast<double>(_total) &&
+               static_cast<double>(_total) >=
+               rebalance_growth * static_cast<double>(m_rebalanced_at.load(std::memory_order_relaxed));
+    }
+} // namespace cxx
+
+#endif // RB_SHARDED_TREE_
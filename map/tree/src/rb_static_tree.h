@@ -0,0 +1,176 @@
+#ifndef   RB_STATIC_TREE_
+# define  RB_STATIC_TREE_
+
+# include <bits/c++config.h>     // For std::size_t
+# include <bits/stl_function.h>  // For std::less
+# include <utility>              // For std::index_sequence, std::make_index_sequence
+
+namespace cxx {
+    /// @brief Fixed-capacity ordered table that can be built and queried at compile time.
+    /// This template class holds up to `N` elements inline, without any heap allocation,
+    /// and all of its operations are `constexpr`. A `constexpr` instance is therefore built
+    /// by the compiler and placed in read-only data, so lookup tables (opcode maps,
+    /// enum-to-handler mappings, ...) cost nothing at startup.
+    /// The elements are stored in key order. The tree has the perfectly balanced shape
+    /// that `rb_tree` gets from a bulk merge: the root of every subtree is the element
+    /// at `(count - 1) / 2` of its range. That shape is implied by the layout, so the
+    /// nodes need no links, and a lookup descends it with at most `height()` comparisons.
+    /// @tparam Key The type of keys used for ordering elements.
+    /// @tparam Val The type of elements stored in the tree. It must be a literal type with
+    ///             a `first` member holding the key, like `std::pair<const Key, T>`.
+    /// @tparam N The capacity of the tree, i.e. the number of elements it is built from.
+    /// @tparam Compare A binary predicate with a `constexpr` call operator that defines the
+    ///                 ordering of elements. Typically, `std::less<Key>`.
+    template<
+        typename Key,
+        typename Val,
+        std::size_t N,
+        typename Compare  = std::less<Key>
+    >
+    class rb_static_tree {
+        static_assert(N > 0, "rb_static_tree needs a capacity of at least one element");
+
+    public:
+        using value_type      = Val;
+        using key_type        = Key;
+        using key_compare     = Compare;
+        using size_type       = std::size_t;
+        using const_reference = const value_type &;
+        using const_iterator  = const value_type *;
+        using iterator        = const_iterator;
+
+        /// @brief Builds the tree from `N` elements given in any order.
+        /// If several elements share a key, the first of them is kept and the others are
+        /// dropped, as with repeated `rb_tree::insert()`; `size()` is then less than `N`.
+        /// Sorting uses insertion sort, which is fine for the table sizes this is meant for.
+        /// @param _vals The elements to store.
+        /// @param comp The comparison object.
+        constexpr explicit rb_static_tree(const value_type (&_vals)[N], const key_compare &comp = key_compare())
+            : rb_static_tree{_vals, comp, _sort(_vals, comp), std::make_index_sequence<N>{}} {
+        }
+
+        /// @brief Returns the number of elements in the tree.
+        [[nodiscard]]
+        constexpr size_type size() const noexcept {
+            return m_size;
+        }
+
+        /// @brief Returns the number of elements the tree was built from.
+        [[nodiscard]]
+        static constexpr size_type capacity() noexcept {
+            return N;
+        }
+
+        /// @brief Checks if the tree is empty.
+        /// @return Always false; a tree is built from at least one element.
+        [[nodiscard]]
+        constexpr bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        /// @brief Returns the height of the tree, i.e. the maximum number of comparisons of a lookup.
+        [[nodiscard]]
+        constexpr size_type height() const noexcept {
+            size_type _height = 0;
+            for (size_type _count = m_size; _count != 0; _count /= 2) {
+                ++_height;
+            }
+            return _height;
+        }
+
+        [[nodiscard]] constexpr const_iterator begin()  const noexcept { return m_values;          }
+        [[nodiscard]] constexpr const_iterator end()    const noexcept { return m_values + m_size; }
+        [[nodiscard]] constexpr const_iterator cbegin() const noexcept { return begin();           }
+        [[nodiscard]] constexpr const_iterator cend()   const noexcept { return end();             }
+
+        /// @brief Looks up an element by key.
+        /// @param _key The key to search for.
+        /// @return Iterator to the element with that key, or `end()` if there is none.
+        [[nodiscard]]
+        constexpr const_iterator find(const key_type &_key) const;
+
+        /// @brief Checks whether an element with the given key exists.
+        [[nodiscard]]
+        constexpr bool contains(const key_type &_key) const {
+            return find(_key) != end();
+        }
+
+    private:
+        /// @brief Positions of the input elements in key order, duplicates removed.
+        struct _order {
+            size_type m_index[N] { }; ///< Input position of each stored element; the tail repeats the last one.
+            size_type m_size     { }; ///< Number of distinct keys.
+        };
+
+        template<std::size_t... I>
+        constexpr rb_static_tree(const value_type (&_vals)[N], const key_compare &comp,
+                                 const _order &_sorted, std::index_sequence<I...>)
+            : m_comp{comp}, m_values{_vals[_sorted.m_index[I]]...}, m_size{_sorted.m_size} {
+        }
+
+        /// @brief Extracts the key from a value.
+        static constexpr const key_type &_key_of(const value_type &_val) noexcept {
+            return _val.first;
+        }
+
+        /// @brief Computes the key order of `_vals`, keeping the first of equal keys.
+        static constexpr _order _sort(const value_type (&_vals)[N], const key_compare &_comp);
+
+        key_compare m_comp;
+        value_type  m_values[N]; ///< The elements in key order; only the first `m_size` are in the tree.
+        size_type   m_size;
+    };
+} // namespace cxx
+
+// Static tree implementation
+namespace cxx {
+    template<typename Key, typename Val, std::size_t N, typename Compare>
+    constexpr typename rb_static_tree<Key, Val, N, Compare>::const_iterator
+    rb_static_tree<Key, Val, N, Compare>::find(const key_type &_key) const {
+        // Descend the implicit tree: each range [_first, _first + _count) is rooted at its midpoint.
+        size_type _first = 0;
+        size_type _count = m_size;
+        while ( _count != 0 ) {
+            const size_type _mid = _first + (_count - 1) / 2;
+            if ( m_comp(_key_of(m_values[_mid]), _key) ) {
+                _count = _first + _count - _mid - 1;
+                _first = _mid + 1;
+            } else if ( m_comp(_key, _key_of(m_values[_mid])) ) {
+                _count = _mid - _first;
+            } else {
+                return m_values + _mid;
+            }
+        }
+        return end();
+    }
+
+    template<typename Key, typename Val, std::size_t N, typename Compare>
+    constexpr typename rb_static_tree<Key, Val, N, Compare>::_order
+    rb_static_tree<Key, Val, N, Compare>::_sort(const value_type (&_vals)[N], const key_compare &_comp) {
+        _order _sorted{};
+        for (size_type _i = 0; _i < N; ++_i) {
+            // Stable insertion: an element only moves in front of strictly greater keys.
+            size_type _j = _i;
+            while (_j > 0 && _comp(_key_of(_vals[_i]), _key_of(_vals[_sorted.m_index[_j - 1]]))) {
+                _sorted.m_index[_j] = _sorted.m_index[_j - 1];
+                --_j;
+            }
+            _sorted.m_index[_j] = _i;
+        }
+
+        // Drop every element whose key equals the one before it, keeping the earliest input.
+        for (size_type _i = 0; _i < N; ++_i) {
+            const size_type _index = _sorted.m_index[_i];
+            if (_sorted.m_size == 0 ||
+                _comp(_key_of(_vals[_sorted.m_index[_sorted.m_size - 1]]), _key_of(_vals[_index]))) {
+                _sorted.m_index[_sorted.m_size++] = _index;
+            }
+        }
+        for (size_type _i = _sorted.m_size; _i < N; ++_i) {
+            _sorted.m_index[_i] = _sorted.m_index[_sorted.m_size - 1];
+        }
+        return _sorted;
+    }
+} // namespace cxx
+
+#endif // RB_STATIC_TREE_
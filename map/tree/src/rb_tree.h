@@ -2,14 +2,26 @@
 # define  RB_TREE_
 
 # include <bits/c++config.h>     // For std::size_t
+# include <cstdint>              // For std::uintptr_t
 # include <bits/stl_function.h>  // For std::less, std::_Select1st
 # include <bits/stl_pair.h>      // For std::pair
+# include <bits/move.h>          // For std::move
+# include <new>                  // For ::operator new, ::operator delete, std::nothrow
 
 # include "rb_tree_node_base.h"  // For rb_tree_node_base
 # include "rb_tree_node.h"       // For rb_tree_node
 # include "rb_tree_iterator.h"   // For rb_tree_iterator, rb_tree_const_iterator
+# include "rb_tree_key_prefix.h" // For rb_tree_key_prefix
+# include "rb_tree_reclaimer.h"  // For rb_tree_reclaim, rb_tree_garbage, rb_tree_reclaimer
+# include "rb_tree_balance.h"    // For rb_tree_red_black
 
 namespace cxx {
+    template<typename Key, typename Val, typename Compare>
+    class rb_buffered_tree;
+
+    template<typename Key, typename Val, typename Compare>
+    class rb_sharded_tree;
+
     /// @brief Red-Black Tree implementation.
     /// This template class provides the structure and functionality for a Red-Black Tree,
     /// a self-balancing binary search tree. It ensures that the tree remains approximately
@@ -21,17 +33,24 @@ namespace cxx {
     /// @tparam Compare A binary predicate that defines the ordering of elements.
     ///                 It should return `true` if the first argument is considered to go before the second.
     ///                 Typically, `std::less<Key>`.
+    ///                 If `rb_tree_key_prefix<Key, Compare>` is enabled (e.g. `std::string` keys
+    ///                 under `std::less`), every node caches a fixed-size prefix of its key and
+    ///                 descents compare prefixes first, calling `Compare` only when they tie.
+    /// @tparam Balance The balancing policy: `rb_tree_red_black`, `rb_tree_avl` or `rb_tree_wavl`.
+    ///                 See `rb_tree_balance.h` for the trade-offs and the policy interface.
 
     template<
         typename Key,
         typename Val,
-        typename Compare  = std::less<Key>
+        typename Compare  = std::less<Key>,
+        typename Balance  = rb_tree_red_black
     >
     class rb_tree {
-        using _node_type            = rb_tree_node<Val>;
+        using _prefix_traits        = rb_tree_key_prefix<Key, Compare>;
+        using _node_type            = typename _prefix_traits::template node_type<Val>;
         using _base_type            = rb_tree_node_base;
         using _color                = rb_tree_node_base::_color;
-        using _node_ptr             = rb_tree_node<Val> *;
+        using _node_ptr             = _node_type *;
         using _base_ptr             = rb_tree_node_base *;
 
     public:
@@ -41,25 +60,54 @@ namespace cxx {
         using pointer         = value_type *;
         using reference       = value_type &;
         using size_type       = std::size_t;
-
-        explicit rb_tree(const key_compare &comp = key_compare())
-            : m_comp{comp}, m_size{0}, m_root{nullptr}, m_nil{nullptr} {
-            m_nil = new _base_type;
-            m_nil->m_color = _color::Black; // nil must be black
-            m_nil->m_parent = m_root;
-            m_root = m_nil;
+        using node_type       = _node_type;
+        using balance_type    = Balance;
+
+        /// @brief Memory report returned by `compact()`.
+        /// The span is the distance in bytes between the lowest and the highest
+        /// node address (plus one node), i.e. the address range a full in-order
+        /// scan has to touch. For a compacted tree it equals `bytes`.
+        struct compact_stats {
+            size_type nodes;       ///< Number of relocated nodes.
+            size_type bytes;       ///< Bytes occupied by the nodes themselves.
+            size_type span_before; ///< Address span of the nodes before compaction.
+            size_type span_after;  ///< Address span of the nodes after compaction.
+        };
+
+        /// @brief Number of destruction steps an `Incremental` tree performs per insertion.
+        static constexpr size_type reclaim_step = 64;
+
+        /// @param comp The comparison object.
+        /// @param reclaim When the nodes dropped by `clear()`, assignment and the destructor
+        ///                are destroyed; see `rb_tree_reclaim`.
+        explicit rb_tree(const key_compare &comp = key_compare(),
+                         rb_tree_reclaim reclaim = rb_tree_reclaim::Immediate)
+            : m_comp{comp}, m_size{0}, m_root{nullptr}, m_nil{nullptr},
+              m_pool{nullptr}, m_pool_size{0}, m_reclaim{reclaim}, m_garbage{nullptr} {
+            if (m_reclaim != rb_tree_reclaim::Immediate) {
+                rb_tree_reclaimer::instance(); // Constructed first, so destroyed after this tree.
+            }
+            m_nil  = _make_nil();
+            if (m_nil == nullptr) {
+                throw std::bad_alloc{};
+            }
+            m_root = static_cast<_node_ptr>(m_nil);
         }
 
         rb_tree(const rb_tree &_x)
-            : rb_tree{_x.m_comp} {
-            _copy(_x.m_root, _x.m_nil);
+            : rb_tree{_x.m_comp, _x.m_reclaim} {
+            _copy(static_cast<_node_ptr>(_x.m_root), _x.m_nil);
             m_size = _x.m_size;
         }
 
         rb_tree &operator=(const rb_tree &_x);
 
+        /// @brief Destroys the tree.
+        /// A `Background` or `Incremental` tree hands its nodes, the nodes still pending
+        /// from earlier `clear()` calls and its sentinel to the reclaimer thread and returns
+        /// without destroying any node; an `Immediate` tree destroys every node before returning.
         ~rb_tree() {
-            _clear(m_root);
+            _detach(false);
         }
 
         /// @brief Returns the number of elements in the tree.
@@ -69,8 +117,8 @@ namespace cxx {
         }
 
         /// @brief Returns a pointer to the root node of the tree.
-        constexpr const _node_ptr getRoot() const {
-            return m_root;
+        constexpr _node_ptr getRoot() const {
+            return static_cast<_node_ptr>(m_root);
         }
 
         /// @brief Returns the height of the entire tree.
@@ -82,7 +130,7 @@ namespace cxx {
 
         /// @brief Returns a pointer to the nil (sentinel) node of the tree.
         [[nodiscard]]
-        constexpr const _base_ptr getNil() const {
+        constexpr _base_ptr getNil() const {
             return m_nil;
         }
 
@@ -94,11 +142,43 @@ namespace cxx {
         }
 
         /// @brief Clears the entire Red-Black Tree.
-        /// This function removes all elements from the tree.
+        /// This function removes all elements from the tree. With `rb_tree_reclaim::Immediate`
+        /// the nodes are destroyed before it returns; otherwise they are detached in O(1)
+        /// and destroyed later (see `rb_tree_reclaim`). The nodes are never destroyed
+        /// recursively, so the shape of the tree does not affect the stack depth.
         void clear() {
-            _clear(m_root);
+            _detach(true);
         }
 
+        /// @brief Destroys nodes detached by earlier `clear()` calls of an `Incremental` tree.
+        /// Call it when the thread is idle to finish the work ahead of later operations.
+        /// @param _budget Maximum number of destruction steps (rotations and deletions).
+        /// @return The number of steps performed.
+        size_type reclaim(size_type _budget);
+
+        /// @brief Checks whether detached nodes are still waiting to be destroyed by this tree.
+        [[nodiscard]]
+        bool reclaim_pending() const noexcept {
+            return m_garbage != nullptr;
+        }
+
+        /// @brief Relocates every node into one contiguous block in in-order order.
+        /// After long runs of insertions the nodes end up scattered across the heap
+        /// and in-order scans are dominated by cache and TLB misses. This function
+        /// moves all values into a single freshly allocated block, laid out in key
+        /// order, and rewires the links so the shape and colors of the tree are kept.
+        /// The relocation is iterative, so its stack use does not depend on the height.
+        /// If copying a value throws, the tree is left unchanged.
+        /// Iterators and node pointers obtained before the call are invalidated.
+        /// @return Node count and address span of the nodes before and after the call.
+        compact_stats compact();
+
+        /// @brief Returns the address span of the nodes of the tree in bytes.
+        /// Compare it against `size() * sizeof(node)` to decide when `compact()` pays off.
+        /// @return Distance between the lowest and the highest node address, plus one node.
+        [[nodiscard]]
+        size_type node_span() const;
+
         /// @brief Returns a pointer to the minimum (leftmost) node in the Red-Black Tree.
         /// @return Pointer to the node with the minimum key.
         constexpr _base_ptr min() const {
@@ -115,21 +195,21 @@ namespace cxx {
         /// @param _val The value to search for (comparison is done using the key extracted from it).
         /// @return Pointer to the node containing the value, or `nullptr`/`_nil` if not found.
         constexpr _node_ptr search(const value_type &_val) const {
-            return _search(m_root, m_nil, _val);
+            return _search(static_cast<_node_ptr>(m_root), m_nil, _val);
         }
 
-        using iterator       = rb_tree_iterator<value_type>;
-        using const_iterator = rb_tree_const_iterator<value_type>;
+        using iterator       = rb_tree_iterator<value_type, _node_type>;
+        using const_iterator = rb_tree_const_iterator<value_type, _node_type>;
 
         /// @brief  Returns an iterator to the smallest element in the Red-Black Tree.
         /// @return Iterator to the beginning of the tree.
         [[nodiscard]]
-        iterator begin() { return iterator{min(), m_nil}; }
+        iterator begin() { return iterator{static_cast<_node_ptr>(min()), m_nil}; }
 
         /// @brief  Returns an iterator to the end of the Red-Black Tree.
         /// @return Iterator to the past-the-end position of the tree.
         [[nodiscard]]
-        iterator end()   { return iterator{m_nil, m_nil}; }
+        iterator end()   { return iterator{static_cast<_node_ptr>(m_nil), m_nil}; }
 
         /// @brief  Returns a const iterator to the smallest element in the Red-Black Tree.
         /// @return Const iterator to the beginning of the tree.
@@ -144,12 +224,12 @@ namespace cxx {
         /// @brief  Returns a const iterator to the smallest element in the Red-Black Tree.
         /// @return Const iterator to the beginning of the tree.
         [[nodiscard]]
-        const_iterator cbegin() const { return const_iterator{min(), m_nil}; }
+        const_iterator cbegin() const { return const_iterator{static_cast<_node_ptr>(min()), m_nil}; }
 
         /// @brief  Returns a const iterator to the end of the Red-Black Tree.
         /// @return Const iterator to the past-the-end position of the tree.
         [[nodiscard]]
-        const_iterator cend()   const { return const_iterator{m_nil, m_nil}; }
+        const_iterator cend()   const { return const_iterator{static_cast<_node_ptr>(m_nil), m_nil}; }
 
         /// @brief Inserts a value into the Red-Black Tree.
         /// @param _val The value to insert into the tree.
@@ -157,10 +237,48 @@ namespace cxx {
         ///   - an iterator to the inserted element (or to the existing one if insertion failed),
         ///   - a boolean indicating whether the insertion took place (`true` if inserted, `false` if already present).
         std::pair<iterator, bool> insert(const value_type &_val) {
-            _ptr_node _node = new _node_type{_val};
+            if (m_garbage != nullptr) {
+                reclaim(reclaim_step);
+            }
+            _node_ptr _node = new _node_type{_val};
             return _insert(_node);
         }
+        /// @brief Removes the element with the key of `_val`, if there is one.
+        /// @param _val A value holding the key to remove.
+        /// @return The number of elements removed (0 or 1).
+        size_type erase(const value_type &_val) {
+            const _node_ptr _node = search(_val);
+            if (_node == m_nil) {
+                return 0;
+            }
+
+            erase(iterator{_node, m_nil});
+            return 1;
+        }
+
+        /// @brief Removes the element at `_pos`.
+        /// Only iterators to the removed element are invalidated.
+        /// @param _pos Iterator to the element to remove; must be dereferenceable.
+        /// @return Iterator to the element following the removed one.
+        iterator erase(iterator _pos) {
+            if (m_garbage != nullptr) {
+                reclaim(reclaim_step);
+            }
+            iterator _next = _pos;
+            ++_next;
+            _unlink(_pos.m_node);
+            _destroy_node(static_cast<_node_ptr>(_pos.m_node));
+            --m_size;
+            return _next;
+        }
+
     private:
+        template<typename, typename, typename>
+        friend class rb_buffered_tree;
+
+        template<typename, typename, typename>
+        friend class rb_sharded_tree;
+
         /// @brief Computes the height of the subtree rooted at the given node.
         /// This internal helper function calculates the height of a subtree, defined as
         /// the number of edges on the longest path from the given node to a leaf.
@@ -168,61 +286,133 @@ namespace cxx {
         /// @return The height of the subtree rooted at `_ptr`. Returns 0 if `_ptr` is null.
         [[nodiscard]]
         constexpr size_type _height(const _base_ptr _ptr) const;
-        /// @brief Recursively clears all nodes in the Red-Black Tree.
-        /// This function deallocates memory and destroys all nodes in the subtree
-        /// rooted at the given node. It is typically used during tree destruction
-        /// or when resetting the tree.
-        /// @param _node Pointer to the root of the subtree to clear.
-        void _clear(_node_ptr _node);
+        /// @brief Allocates a black sentinel whose parent is itself.
+        /// @return The sentinel, or `nullptr` if it cannot be allocated.
+        static _base_ptr _make_nil() noexcept;
+
+        /// @brief Detaches every node and leaves the tree empty.
+        /// The nodes and the `compact()` block are wrapped into an `rb_tree_garbage` that is
+        /// destroyed right away, queued on this tree or handed to the reclaimer thread,
+        /// depending on the reclaim policy. Garbage handed to the reclaimer takes the sentinel
+        /// along and the tree gets a new one. When an `Incremental` tree is released, the
+        /// garbage it still queues shares that sentinel and is handed over in front of it.
+        /// If any allocation fails the nodes are destroyed right away instead.
+        /// @param _keep Whether the tree stays usable; if not, its sentinel is released too.
+        void _detach(bool _keep) noexcept;
+
+        /// @brief Destroys one node handed back by an `rb_tree_garbage`.
+        /// @param _node Pointer to the node to destroy.
+        /// @param _pooled Whether the node lives in a `compact()` block, whose memory is freed separately.
+        static void _reclaim_node(_base_ptr _node, bool _pooled) noexcept;
         /// @brief Recursively copies nodes from another Red-Black Tree.
         /// This internal helper function is used to deep-copy the structure and values
         /// of another Red-Black Tree into the current tree. It clones the subtree rooted
         /// at `_node`, skipping over the sentinel `_nil` node used in Red-Black Trees.
         /// @param _node Pointer to the current node in the source tree to copy.
         /// @param _nil Sentinel node pointer used to represent leaf (null) nodes in the source tree.
-        void _copy(const _node_ptr _node, const _base_ptr const _nil);
+        void _copy(const _node_ptr _node, const _base_ptr _nil);
+
+        /// @brief Moves the values of `_nodes` into the matching slots of `_pool` and rewires the links.
+        /// Every value is constructed in the block before any link or old node is touched;
+        /// if one of those constructions throws, the constructed slots are destroyed, the
+        /// block is freed and the tree is left unchanged. Afterwards the links of each old
+        /// node are translated to the block and the old nodes are destroyed.
+        /// @param _nodes The nodes of the tree in in-order order.
+        /// @param _pool Destination block with room for `m_size` nodes.
+        void _relocate(_node_ptr *_nodes, _node_ptr _pool);
+
+        /// @brief Destroys a single node, returning its memory unless it lives in `m_pool`.
+        /// @param _node Pointer to the node to destroy.
+        void _destroy_node(_node_ptr _node) noexcept;
+
+        /// @brief Frees the block allocated by the last `compact()`.
+        /// Must only be called once every node stored in the block has been destroyed.
+        void _release_pool() noexcept;
 
         /// @brief Compares two values based on their extracted keys.
         /// @param _x The first value to compare.
         /// @param _y The second value to compare.
         /// @return `true` if the key of `_x` is less than the key of `_y`, otherwise `false`.
-        bool _compare(const value_type& _x, const value_type& _y) {
-            const key_type keyX = std::_Select1st<value_type>()(_x);
-            const key_type keyY = std::_Select1st<value_type>()(_y);
+        bool _compare(const value_type& _x, const value_type& _y) const {
+            const key_type &keyX = std::_Select1st<value_type>()(_x);
+            const key_type &keyY = std::_Select1st<value_type>()(_y);
             return m_comp(keyX, keyY);
         }
 
-        /// @brief Recursively searches for a node with the given value starting from a specific node.
-        /// @param _ptr Pointer to the current node in the subtree being searched.
+        /// @brief Searches for a node with the given value starting from a specific node.
+        /// With prefix caching enabled the prefix of `_val` is computed once and compared
+        /// against each node's cached prefix; `_compare` only runs on nodes whose prefix ties.
+        /// @param _ptr Pointer to the root of the subtree being searched.
         /// @param _nil Sentinel node used to represent leaf/null nodes.
         /// @param _val The value to search for (comparison is based on the key extracted from it).
         /// @return Pointer to the node containing the value, or `_nil` if not found.
         constexpr _node_ptr
-        _search(const _node_ptr _ptr, const _base_ptr const _nil, const value_type &_val);
+        _search(const _node_ptr _ptr, const _base_ptr _nil, const value_type &_val) const;
 
         /// @brief Internal helper to insert a node into the Red-Black Tree.
-        /// @param _node Pointer to the node to insert.
+        /// @param _node Pointer to the node to insert. The tree takes ownership of it;
+        ///              if its key is already present the node is deleted.
         /// @return A pair consisting of:
         ///   - an iterator to the inserted node (or to the existing one if a duplicate key is found),
         ///   - a boolean indicating whether the insertion was successful (`true` if inserted, `false` if duplicate).
         std::pair<iterator, bool> _insert(_node_ptr _node);
 
-        /// @brief Restores Red-Black Tree properties after insertion.
-        /// This internal function is called after inserting a node to fix any violations
-        /// of Red-Black Tree properties (such as two consecutive red nodes). It performs
-        /// the necessary re-coloring and rotations to maintain the tree's balance.
-        /// @param _node Pointer to the newly inserted node that may violate Red-Black rules.
-        void _insert_fix_up(_node_ptr _node);
-
+        /// @brief Unlinks a node from the tree and rebalances it, without destroying the node.
+        /// A node with two children first trades places with its in-order successor, which
+        /// has no left child, so the node that is unlinked never has more than one child.
+        /// Iterators to other elements stay valid.
+        /// @param _node Pointer to the node to unlink.
+        void _unlink(_base_ptr _node) noexcept;
+
+        /// @brief Links a batch of detached nodes into the Red-Black Tree.
+        /// The tree takes ownership of every node in the batch. A node whose key is
+        /// already in the tree is deleted and the existing element is kept. Small batches
+        /// are inserted one by one. Once `_count * log2(size())` descents would cost more
+        /// than touching every node, the batch is merged with the in-order sequence of the
+        /// tree instead and the whole tree is rebuilt, perfectly balanced, in
+        /// O(size() + _count).
+        /// @param _nodes Array of `_count` nodes allocated with `new`, sorted by key and
+        ///               free of duplicate keys among themselves.
+        /// @param _count Number of nodes in the batch.
+        void _merge_sorted(_node_ptr *_nodes, size_type _count);
+
+        /// @brief Replaces the nodes of an empty tree with `_count` sorted nodes, perfectly balanced.
+        /// @param _nodes Array of `_count` nodes allocated with `new`, sorted by key and
+        ///               free of duplicate keys. The tree takes ownership of them.
+        /// @param _count Number of nodes in `_nodes`.
+        void _link_sorted(_node_ptr *_nodes, size_type _count) noexcept;
+
+        /// @brief Hands every node over to the caller in key order and leaves the tree empty.
+        /// The nodes keep their values; their links are stale until they are linked again,
+        /// e.g. by `_link_sorted()`. The tree must not hold a `compact()` block.
+        /// @param _out Array with room for `size()` nodes.
+        void _take_nodes(_node_ptr *_out) noexcept;
+
+        /// @brief Links `_count` sorted nodes into a perfectly balanced subtree.
+        /// The middle node becomes the root and both halves are built recursively, so
+        /// every leaf ends up on one of the two deepest levels and the recursion depth
+        /// is O(log _count). The balancing policy then sets the balance information of each
+        /// node (`Balance::_built()`): for red-black, nodes on the last, incomplete level are
+        /// colored red and all others black, which satisfies the Red-Black properties
+        /// without any rotation.
+        /// @param _nodes Array of nodes in increasing key order.
+        /// @param _count Number of nodes in `_nodes`.
+        /// @param _depth Depth of the subtree root, the tree root being at depth 0.
+        /// @param _red_depth Depth of the last, incomplete level.
+        /// @return Pointer to the root of the built subtree, or `m_nil` if `_count` is 0.
+        _base_ptr _build_sorted(_node_ptr *_nodes, size_type _count,
+                                size_type _depth, size_type _red_depth) noexcept;
 
 
-        void _right_rotate(_base_ptr _node) noexcept;
-        void _left_rotate (_base_ptr _node) noexcept;
 
         key_compare m_comp;
         size_type m_size;
-        _node_ptr m_root;
+        _base_ptr m_root;
         _base_ptr m_nil;
+        _node_ptr m_pool;      ///< Contiguous node block from the last `compact()`, if any.
+        size_type m_pool_size; ///< Number of node slots in `m_pool`.
+        rb_tree_reclaim  m_reclaim;
+        rb_tree_garbage *m_garbage; ///< Detached trees an `Incremental` tree still has to destroy.
     };
 
 
@@ -230,160 +420,496 @@ namespace cxx {
 
 // Red-Black Tree implementation
 namespace cxx {
-    template<typename Key, typename Val, typename Compare>
-    rb_tree<Key, Val, Compare> &
-    rb_tree<Key, Val, Compare>::operator=(const rb_tree &_x) {
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    rb_tree<Key, Val, Compare, Balance> &
+    rb_tree<Key, Val, Compare, Balance>::operator=(const rb_tree &_x) {
         if (this == &_x) {
             return *this;
         }
 
-        _clear(m_root);
-        m_root = m_nil;
+        _detach(true);
         m_comp = _x.m_comp;
-        _copy(_x.m_root, _x.m_nil);
+        _copy(static_cast<_node_ptr>(_x.m_root), _x.m_nil);
         m_size = _x.m_size;
         return *this;
     }
 
-    template<typename Key, typename Val, typename Compare>
+    template<typename Key, typename Val, typename Compare, typename Balance>
     constexpr std::size_t
-    rb_tree<Key, Val, Compare>::_height(const _base_ptr _ptr) const {
+    rb_tree<Key, Val, Compare, Balance>::_height(const _base_ptr _ptr) const {
         if (_ptr == m_nil) {
             return 0;
         }
 
-        const size_type _l = height(_ptr->m_left);
-        const size_type _r = height(_ptr->m_right);
+        const size_type _l = _height(_ptr->m_left);
+        const size_type _r = _height(_ptr->m_right);
         return 1 + (_l > _r ? _l : _r);
     }
 
-    template<typename Key, typename Val, typename Compare>
-    void rb_tree<Key, Val, Compare>::_clear(_node_ptr _node) {
-        if (_node == m_nil) {
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    typename rb_tree<Key, Val, Compare, Balance>::size_type
+    rb_tree<Key, Val, Compare, Balance>::reclaim(size_type _budget) {
+        size_type _steps = 0;
+        while (m_garbage != nullptr && _steps < _budget) {
+            _steps += m_garbage->reclaim(_budget - _steps);
+            if (m_garbage->done()) {
+                rb_tree_garbage *const _next = m_garbage->m_next;
+                delete m_garbage;
+                m_garbage = _next;
+            }
+        }
+        return _steps;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    rb_tree_node_base *rb_tree<Key, Val, Compare, Balance>::_make_nil() noexcept {
+        _base_ptr _nil = new (std::nothrow) _base_type;
+        if (_nil != nullptr) {
+            _nil->m_color  = _color::Black; // nil must be black
+            _nil->m_parent = _nil;          // Tracks the root, so that --end() finds the maximum
+        }
+        return _nil;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_detach(bool _keep) noexcept {
+        const size_type  _pool_bytes = m_pool_size * sizeof(_node_type);
+        // Garbage handed to the reclaimer may outlive the tree, so it takes the sentinel along.
+        const bool       _give_nil   = m_reclaim == rb_tree_reclaim::Background ||
+                                       (m_reclaim == rb_tree_reclaim::Incremental && !_keep);
+        _base_ptr        _nil        = m_nil;
+        rb_tree_garbage *_garbage    = nullptr;
+
+        if (m_reclaim != rb_tree_reclaim::Immediate &&
+            (m_root != m_nil || (_give_nil && m_garbage != nullptr))) {
+            if (_give_nil) {
+                _nil = _keep ? _make_nil() : nullptr;
+            }
+            if (_nil != nullptr || !_keep) {
+                _garbage = new (std::nothrow) rb_tree_garbage{m_root, m_nil, _give_nil, m_pool,
+                                                              _pool_bytes, &_reclaim_node};
+            }
+            if (_garbage == nullptr) {
+                if (_nil != m_nil) {
+                    delete _nil;
+                }
+                _nil = m_nil;
+            }
+        }
+
+        if (_garbage == nullptr) {
+            // Immediate policy, empty tree or out of memory: destroy the nodes right here.
+            rb_tree_garbage{m_root, m_nil, false, m_pool, _pool_bytes, &_reclaim_node};
+            while (!_keep && m_garbage != nullptr) {
+                rb_tree_garbage *const _next = m_garbage->m_next;
+                delete m_garbage;
+                m_garbage = _next;
+            }
+        } else if (_give_nil) {
+            // Queued garbage uses the sentinel the new garbage deletes, so it is destroyed first.
+            rb_tree_garbage *_first = _garbage;
+            if (m_garbage != nullptr) {
+                _first = m_garbage;
+                while (m_garbage->m_next != nullptr) {
+                    m_garbage = m_garbage->m_next;
+                }
+                m_garbage->m_next = _garbage;
+                m_garbage = nullptr;
+            }
+            rb_tree_reclaimer::instance().push(_first);
+        } else {
+            _garbage->m_next = m_garbage;
+            m_garbage = _garbage;
+        }
+
+        if (!_keep) {
+            delete _nil;
+            _nil = nullptr;
+        }
+        m_pool      = nullptr;
+        m_pool_size = 0;
+        m_size      = 0;
+        m_nil       = _nil;
+        m_root      = static_cast<_node_ptr>(m_nil);
+        if (m_nil != nullptr) {
+            m_nil->m_parent = m_nil;
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_reclaim_node(_base_ptr _node, bool _pooled) noexcept {
+        const _node_ptr _ptr = static_cast<_node_ptr>(_node);
+        if (_pooled) {
+            _ptr->~_node_type();
             return ;
         }
 
-        _clear(_node->m_left);
-        _clear(_node->m_right);
-        delete _node;
-        --m_size;
+        delete _ptr;
     }
 
-    template<typename Key, typename Val, typename Compare>
-    void rb_tree<Key, Val, Compare>::
-    _copy(const _node_ptr _node, const _base_ptr const _nil) {
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::
+    _copy(const _node_ptr _node, const _base_ptr _nil) {
         if (_node == _nil) {
             return ;
         }
 
         insert(_node->m_valueField);
-        _copy(_node->m_left, _nil);
-        _copy(_node->m_right, _nil);
+        _copy(static_cast<_node_ptr>(_node->m_left), _nil);
+        _copy(static_cast<_node_ptr>(_node->m_right), _nil);
     }
 
-    template<typename Key, typename Val, typename Compare>
-    constexpr rb_tree_node<Val> *rb_tree<Key, Val, Compare>::
-    _search(const _node_ptr _ptr, const _base_ptr const _nil, const value_type &_val) {
-        if ( _ptr == _nil ) {
-            return _ptr;
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    typename rb_tree<Key, Val, Compare, Balance>::compact_stats
+    rb_tree<Key, Val, Compare, Balance>::compact() {
+        compact_stats _stats { m_size, m_size * sizeof(_node_type), node_span(), 0 };
+        if (m_size == 0) {
+            return _stats;
         }
 
-        if ( _compare(_ptr->m_valueField, _val) ) {
-            return _search(_ptr->m_right, _nil, _val);
+        _node_ptr *_nodes = new _node_ptr[m_size];
+        size_type  _index = 0;
+        for (_base_ptr _it = min(); _it != m_nil; _it = _base_type::_next(_it, m_nil)) {
+            _nodes[_index++] = static_cast<_node_ptr>(_it);
         }
 
-        if ( _compare(_val, _ptr->m_valueField) ) {
-            return _search(_ptr->m_left, _nil, _val);
+        _node_ptr _pool = nullptr;
+        try {
+            _pool = static_cast<_node_ptr>(::operator new(m_size * sizeof(_node_type)));
+            _relocate(_nodes, _pool);
+        } catch (...) {
+            delete[] _nodes;
+            throw;
         }
+        delete[] _nodes;
 
-        return _ptr;
+        _release_pool();
+        m_pool      = _pool;
+        m_pool_size = m_size;
+
+        _stats.span_after = node_span();
+        return _stats;
     }
 
-    template<typename Key, typename Val, typename Compare>
-    std::pair<typename rb_tree<Key, Val, Compare>::iterator, bool>
-    rb_tree<Key, Val, Compare>::_insert(_node_ptr _node) {
-        _node_ptr _current { m_root };
-        _node_ptr _parent  { m_nil  };
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    std::size_t rb_tree<Key, Val, Compare, Balance>::node_span() const {
+        if (m_size == 0) {
+            return 0;
+        }
+
+        // The nodes need not share an allocation, so compare addresses as integers.
+        std::uintptr_t _low  = UINTPTR_MAX;
+        std::uintptr_t _high = 0;
+        for (_base_ptr _it = min(); _it != m_nil; _it = _base_type::_next(_it, m_nil)) {
+            const std::uintptr_t _addr = reinterpret_cast<std::uintptr_t>(_it);
+            if (_addr < _low) {
+                _low = _addr;
+            }
+            if (_addr > _high) {
+                _high = _addr;
+            }
+        }
+        return static_cast<size_type>(_high - _low) + sizeof(_node_type);
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_relocate(_node_ptr *_nodes, _node_ptr _pool) {
+        // Values are moved only when that cannot throw; otherwise they are copied
+        // so the old nodes stay intact until every slot has been built.
+        size_type _built = 0;
+        try {
+            for (; _built < m_size; ++_built) {
+                ::new (static_cast<void *>(_pool + _built))
+                    _node_type{std::move_if_noexcept(_nodes[_built]->m_valueField)};
+            }
+        } catch (...) {
+            while (_built > 0) {
+                _pool[--_built].~_node_type();
+            }
+            ::operator delete(_pool);
+            throw;
+        }
+
+        // Copy the old links, then leave a forwarding pointer to the new slot in
+        // each old node's parent link and translate the copied links through it.
+        for (size_type _i = 0; _i < m_size; ++_i) {
+            _pool[_i].m_color  = _nodes[_i]->m_color;
+            _pool[_i].m_rank   = _nodes[_i]->m_rank;
+            _pool[_i].m_parent = _nodes[_i]->m_parent;
+            _pool[_i].m_left   = _nodes[_i]->m_left;
+            _pool[_i].m_right  = _nodes[_i]->m_right;
+        }
+        for (size_type _i = 0; _i < m_size; ++_i) {
+            _nodes[_i]->m_parent = _pool + _i;
+        }
+        for (size_type _i = 0; _i < m_size; ++_i) {
+            if (_pool[_i].m_parent != m_nil) {
+                _pool[_i].m_parent = _pool[_i].m_parent->m_parent;
+            }
+            if (_pool[_i].m_left != m_nil) {
+                _pool[_i].m_left = _pool[_i].m_left->m_parent;
+            }
+            if (_pool[_i].m_right != m_nil) {
+                _pool[_i].m_right = _pool[_i].m_right->m_parent;
+            }
+        }
+
+        m_root = m_root->m_parent;
+        m_nil->m_parent = m_root;
+        for (size_type _i = 0; _i < m_size; ++_i) {
+            _destroy_node(_nodes[_i]);
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_destroy_node(_node_ptr _node) noexcept {
+        const std::less<const void *> _before;
+        if (m_pool != nullptr && !_before(_node, m_pool) && _before(_node, m_pool + m_pool_size)) {
+            _node->~_node_type();
+            return ;
+        }
+
+        delete _node;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_release_pool() noexcept {
+        ::operator delete(m_pool);
+        m_pool      = nullptr;
+        m_pool_size = 0;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    constexpr typename rb_tree<Key, Val, Compare, Balance>::_node_ptr rb_tree<Key, Val, Compare, Balance>::
+    _search(const _node_ptr _ptr, const _base_ptr _nil, const value_type &_val) const {
+        if constexpr ( _prefix_traits::enabled ) {
+            const auto _prefix = _prefix_traits::make(std::_Select1st<value_type>()(_val));
+            _base_ptr  _current { _ptr };
+            while ( _current != _nil ) {
+                const _node_ptr _node = static_cast<_node_ptr>(_current);
+                if ( _prefix != _node->m_prefix ) {
+                    _current = _prefix < _node->m_prefix ? _node->m_left : _node->m_right;
+                } else if ( _compare(_node->m_valueField, _val) ) {
+                    _current = _node->m_right;
+                } else if ( _compare(_val, _node->m_valueField) ) {
+                    _current = _node->m_left;
+                } else {
+                    return _node;
+                }
+            }
+            return static_cast<_node_ptr>(_current);
+        } else {
+            if ( _ptr == _nil ) {
+                return _ptr;
+            }
+
+            if ( _compare(_ptr->m_valueField, _val) ) {
+                return _search(static_cast<_node_ptr>(_ptr->m_right), _nil, _val);
+            }
+
+            if ( _compare(_val, _ptr->m_valueField) ) {
+                return _search(static_cast<_node_ptr>(_ptr->m_left), _nil, _val);
+            }
+
+            return _ptr;
+        }
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    std::pair<typename rb_tree<Key, Val, Compare, Balance>::iterator, bool>
+    rb_tree<Key, Val, Compare, Balance>::_insert(_node_ptr _node) {
+        _base_ptr _current { m_root };
+        _base_ptr _parent  { m_nil  };
+        bool      _left    { false  };
 
         while ( _current != m_nil ) {
             _parent = _current;
-            if ( !_compare(_node->m_valueField, _current->m_valueField) &&
-                !_compare(_current->m_valueField, _node->m_valueField) ) {
-                return std::make_pair(iterator{_current, m_nil}, false);
+            const _node_ptr _current_node = static_cast<_node_ptr>(_current);
+            if constexpr ( _prefix_traits::enabled ) {
+                if ( _node->m_prefix != _current_node->m_prefix ) {
+                    _left    = _node->m_prefix < _current_node->m_prefix;
+                    _current = _left ? _current->m_left : _current->m_right;
+                    continue;
+                }
             }
 
-            if ( _compare(_node->m_valueField, _current->m_valueField) ) {
-                _current = _current->m_left;
-            } else {
-                _current = _current->m_right;
+            const value_type &_current_val = _current_node->m_valueField;
+            _left = _compare(_node->m_valueField, _current_val);
+            if ( !_left && !_compare(_current_val, _node->m_valueField) ) {
+                delete _node;
+                return std::make_pair(iterator{_current_node, m_nil}, false);
             }
+
+            _current = _left ? _current->m_left : _current->m_right;
         }
 
         _node->m_parent = _parent;
+        _node->m_left   = m_nil;
+        _node->m_right  = m_nil;
         if ( _parent == m_nil ) {
             m_root = _node;
-        } else if ( _compare(_node->m_valueField, _parent->m_valueField) ) {
+        } else if ( _left ) {
             _parent->m_left = _node;
         } else {
             _parent->m_right = _node;
         }
 
         ++m_size;
-        _insert_fix_up(_node);
+        Balance::_insert_fix_up(_node, m_root, m_nil);
+        m_nil->m_parent = m_root;
         return std::make_pair(iterator{_node, m_nil}, true);
     }
 
-    template<typename Key, typename Val, typename Compare>
-    void rb_tree<Key, Val, Compare>::_insert_fix_up(_node_ptr _node) {
-        while ( _node->m_parent->m_color == _color::Red ) {
-            if ( _node->m_parent == _node->m_parent->m_parent->m_left ) {
-                _base_ptr _uncle = _node->m_parent->m_parent->m_right;
-                if ( _uncle->m_color == _color::Red ) {
-                    // Case 1: parent and uncle are red
-                    _base_type::_resolve_red_uncle(_node->m_parent, _uncle);
-                    _node = _node->m_parent->m_parent;
-                } else {
-                    // parent is red and uncle is BLACK
-                    if ( _node == _node->m_parent->m_right ) {
-                        // Case 2: _node is a right child
-                        _node = _node->m_parent;
-                        _left_rotate(_node);
-                    }
-                    // Case 3: _node is a left child
-                    _base_type::_resolve_red_parent(_node->m_parent);
-                    _right_rotate(_node->m_parent->m_parent);
-                }
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_unlink(_base_ptr _node) noexcept {
+        if ( _node->m_left != m_nil && _node->m_right != m_nil ) {
+            // Put the successor where _node is and _node where the successor was.
+            const _base_ptr _next   = _base_type::_minimum(_node->m_right, m_nil);
+            const _base_ptr _parent = _node->m_parent;
+            const _base_ptr _right  = _next->m_right;
+
+            if ( _parent == m_nil ) {
+                m_root = _next;
+            } else if ( _parent->m_left == _node ) {
+                _parent->m_left = _next;
             } else {
-                _base_ptr _uncle = _node->m_parent->m_parent->m_left;
-                if ( _uncle->m_color == _color::Red ) {
-                    // Case 1: parent and uncle are red
-                    _base_type::_resolve_red_uncle(_node->m_parent, _uncle);
-                    _node = _node->m_parent->m_parent;
-                } else {
-                    // parent is red and uncle is BLACK
-                    if ( _node == _node->m_parent->m_left ) {
-                        // Case 2: _node is a right child
-                        _node = _node->m_parent;
-                        _right_rotate(_node);
-                    }
-                    // Case 3: _node is a left child
-                    _base_type::_resolve_red_parent(_node->m_parent);
-                    _left_rotate(_node->m_parent->m_parent);
-                }
+                _parent->m_right = _next;
             }
+
+            _next->m_left = _node->m_left;
+            _next->m_left->m_parent = _next;
+            if ( _next->m_parent == _node ) {
+                _next->m_right  = _node;
+                _node->m_parent = _next;
+            } else {
+                _next->m_right = _node->m_right;
+                _next->m_right->m_parent = _next;
+                _node->m_parent = _next->m_parent;
+                _node->m_parent->m_left = _node;
+            }
+            _next->m_parent = _parent;
+
+            _node->m_left  = m_nil;
+            _node->m_right = _right;
+            if ( _right != m_nil ) {
+                _right->m_parent = _node;
+            }
+
+            // The balance information belongs to the position, not to the element.
+            const _color _next_color = _next->m_color;
+            const int    _next_rank  = _next->m_rank;
+            _next->m_color = _node->m_color;
+            _next->m_rank  = _node->m_rank;
+            _node->m_color = _next_color;
+            _node->m_rank  = _next_rank;
+        }
+
+        const _base_ptr _child  = _node->m_left != m_nil ? _node->m_left : _node->m_right;
+        const _base_ptr _parent = _node->m_parent;
+        const bool      _left   = _parent != m_nil && _parent->m_left == _node;
+        if ( _child != m_nil ) {
+            _child->m_parent = _parent;
         }
-        m_root->m_color = _color::Black;
+        if ( _parent == m_nil ) {
+            m_root = _child;
+        } else if ( _left ) {
+            _parent->m_left = _child;
+        } else {
+            _parent->m_right = _child;
+        }
+
+        Balance::_erase_fix_up(_node, _child, _parent, _left, m_root, m_nil);
+        m_nil->m_parent = m_root;
     }
 
-    template <typename Key, typename Val, typename Compare>
-    void rb_tree<Key, Val, Compare>::_right_rotate(_base_ptr _node) noexcept
-    {
-        
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_merge_sorted(_node_ptr *_nodes, size_type _count) {
+        if (_count == 0) {
+            return ;
+        }
+
+        size_type _log = 0;
+        while ((size_type{1} << _log) <= m_size) {
+            ++_log;
+        }
+
+        if (_count * _log < m_size) {
+            for (size_type _i = 0; _i < _count; ++_i) {
+                _insert(_nodes[_i]);
+            }
+            return ;
+        }
+
+        _node_ptr *_all = new _node_ptr[m_size + _count];
+
+        // Merge the in-order sequence of the tree with the batch, dropping batch
+        // nodes whose key the tree already holds.
+        _base_ptr _it    = min();
+        size_type _i     = 0;
+        size_type _total = 0;
+        while (_it != m_nil || _i < _count) {
+            const _node_ptr _tree_node = static_cast<_node_ptr>(_it);
+            if (_i == _count || (_it != m_nil &&
+                _compare(_tree_node->m_valueField, _nodes[_i]->m_valueField))) {
+                _all[_total++] = _tree_node;
+                _it = _base_type::_next(_it, m_nil);
+            } else if (_it != m_nil && !_compare(_nodes[_i]->m_valueField, _tree_node->m_valueField)) {
+                delete _nodes[_i++];
+            } else {
+                _all[_total++] = _nodes[_i++];
+            }
+        }
+
+        _link_sorted(_all, _total);
+        delete[] _all;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_link_sorted(_node_ptr *_nodes, size_type _count) noexcept {
+        // Nodes at depth floor(log2(_count + 1)) form the incomplete last level.
+        size_type _red_depth = 0;
+        while ((size_type{2} << _red_depth) <= _count + 1) {
+            ++_red_depth;
+        }
+
+        m_root = _build_sorted(_nodes, _count, 0, _red_depth);
+        m_root->m_parent = m_nil;
+        m_nil->m_parent  = m_root;
+        m_size = _count;
+    }
+
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    void rb_tree<Key, Val, Compare, Balance>::_take_nodes(_node_ptr *_out) noexcept {
+        size_type _i = 0;
+        for (_base_ptr _it = min(); _it != m_nil; _it = _base_type::_next(_it, m_nil)) {
+            _out[_i++] = static_cast<_node_ptr>(_it);
+        }
+
+        m_root          = m_nil;
+        m_nil->m_parent = m_nil;
+        m_size          = 0;
     }
 
-    template <typename Key, typename Val, typename Compare>
-    void rb_tree<Key, Val, Compare>::_left_rotate(_base_ptr _node) noexcept
-    {
+    template<typename Key, typename Val, typename Compare, typename Balance>
+    rb_tree_node_base *rb_tree<Key, Val, Compare, Balance>::
+    _build_sorted(_node_ptr *_nodes, size_type _count, size_type _depth, size_type _red_depth) noexcept {
+        if (_count == 0) {
+            return m_nil;
+        }
+
+        const size_type _mid  = (_count - 1) / 2;
+        const _node_ptr _node = _nodes[_mid];
+
+        _node->m_left  = _build_sorted(_nodes, _mid, _depth + 1, _red_depth);
+        _node->m_right = _build_sorted(_nodes + _mid + 1, _count - _mid - 1, _depth + 1, _red_depth);
+        Balance::_built(_node, _depth == _red_depth, m_nil);
+        if (_node->m_left != m_nil) {
+            _node->m_left->m_parent = _node;
+        }
+        if (_node->m_right != m_nil) {
+            _node->m_right->m_parent = _node;
+        }
+        return _node;
     }
 }
 
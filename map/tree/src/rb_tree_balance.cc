@@ -0,0 +1,286 @@
+#include "rb_tree_balance.h"
+
+namespace cxx {
+    namespace {
+        using _base_ptr = rb_tree_node_base *;
+        using _color    = rb_tree_node_color;
+
+        /// @brief Returns the larger rank of the two children of `_node`.
+        int _max_child_rank(_base_ptr _node) noexcept {
+            const int _l = _node->m_left->m_rank;
+            const int _r = _node->m_right->m_rank;
+            return _l > _r ? _l : _r;
+        }
+
+        /// @brief Sets the height of `_node` from its children, for AVL balancing.
+        void _update_height(_base_ptr _node) noexcept {
+            _node->m_rank = _max_child_rank(_node) + 1;
+        }
+    } // namespace
+
+    // Red-black balancing
+    void rb_tree_red_black::_insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept {
+        _node->m_color = _color::Red;
+        while ( _node->m_parent->m_color == _color::Red ) {
+            if ( _node->m_parent == _node->m_parent->m_parent->m_left ) {
+                _base_ptr _uncle = _node->m_parent->m_parent->m_right;
+                if ( _uncle->m_color == _color::Red ) {
+                    // Case 1: parent and uncle are red
+                    rb_tree_node_base::_resolve_red_uncle(_node->m_parent, _uncle);
+                    _node = _node->m_parent->m_parent;
+                } else {
+                    // parent is red and uncle is BLACK
+                    if ( _node == _node->m_parent->m_right ) {
+                        // Case 2: _node is a right child
+                        _node = _node->m_parent;
+                        rb_tree_node_base::_rotate_left(_node, _root, _nil);
+                    }
+                    // Case 3: _node is a left child
+                    rb_tree_node_base::_resolve_red_parent(_node->m_parent);
+                    rb_tree_node_base::_rotate_right(_node->m_parent->m_parent, _root, _nil);
+                }
+            } else {
+                _base_ptr _uncle = _node->m_parent->m_parent->m_left;
+                if ( _uncle->m_color == _color::Red ) {
+                    // Case 1: parent and uncle are red
+                    rb_tree_node_base::_resolve_red_uncle(_node->m_parent, _uncle);
+                    _node = _node->m_parent->m_parent;
+                } else {
+                    // parent is red and uncle is BLACK
+                    if ( _node == _node->m_parent->m_left ) {
+                        // Case 2: _node is a left child
+                        _node = _node->m_parent;
+                        rb_tree_node_base::_rotate_right(_node, _root, _nil);
+                    }
+                    // Case 3: _node is a right child
+                    rb_tree_node_base::_resolve_red_parent(_node->m_parent);
+                    rb_tree_node_base::_rotate_left(_node->m_parent->m_parent, _root, _nil);
+                }
+            }
+        }
+        _root->m_color = _color::Black;
+    }
+
+    void rb_tree_red_black::_erase_fix_up(_base_ptr _removed, _base_ptr _child, _base_ptr _parent, bool _left,
+                                          _base_ptr &_root, _base_ptr _nil) noexcept {
+        if ( _removed->m_color == _color::Red ) {
+            return ;
+        }
+
+        // _child carries an extra black; push it up until it lands on a red node or the root.
+        while ( _child != _root && _child->m_color == _color::Black ) {
+            if ( _left ) {
+                _base_ptr _sibling = _parent->m_right;
+                if ( _sibling->m_color == _color::Red ) {
+                    // Case 1: red sibling, rotate it above the parent
+                    _sibling->m_color = _color::Black;
+                    _parent->m_color  = _color::Red;
+                    rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                    _sibling = _parent->m_right;
+                }
+                if ( _sibling->m_left->m_color == _color::Black && _sibling->m_right->m_color == _color::Black ) {
+                    // Case 2: black sibling with black children, move the extra black up
+                    _sibling->m_color = _color::Red;
+                    _child  = _parent;
+                    _parent = _child->m_parent;
+                    _left   = _child == _parent->m_left;
+                } else {
+                    if ( _sibling->m_right->m_color == _color::Black ) {
+                        // Case 3: only the inner nephew is red, turn it into case 4
+                        _sibling->m_left->m_color = _color::Black;
+                        _sibling->m_color = _color::Red;
+                        rb_tree_node_base::_rotate_right(_sibling, _root, _nil);
+                        _sibling = _parent->m_right;
+                    }
+                    // Case 4: red outer nephew, one rotation absorbs the extra black
+                    _sibling->m_color = _parent->m_color;
+                    _parent->m_color  = _color::Black;
+                    _sibling->m_right->m_color = _color::Black;
+                    rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                    _child = _root;
+                }
+            } else {
+                _base_ptr _sibling = _parent->m_left;
+                if ( _sibling->m_color == _color::Red ) {
+                    _sibling->m_color = _color::Black;
+                    _parent->m_color  = _color::Red;
+                    rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                    _sibling = _parent->m_left;
+                }
+                if ( _sibling->m_right->m_color == _color::Black && _sibling->m_left->m_color == _color::Black ) {
+                    _sibling->m_color = _color::Red;
+                    _child  = _parent;
+                    _parent = _child->m_parent;
+                    _left   = _child == _parent->m_left;
+                } else {
+                    if ( _sibling->m_left->m_color == _color::Black ) {
+                        _sibling->m_right->m_color = _color::Black;
+                        _sibling->m_color = _color::Red;
+                        rb_tree_node_base::_rotate_left(_sibling, _root, _nil);
+                        _sibling = _parent->m_left;
+                    }
+                    _sibling->m_color = _parent->m_color;
+                    _parent->m_color  = _color::Black;
+                    _sibling->m_left->m_color = _color::Black;
+                    rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                    _child = _root;
+                }
+            }
+        }
+        _child->m_color = _color::Black;
+    }
+
+    void rb_tree_red_black::_built(_base_ptr _node, bool _last_level, _base_ptr) noexcept {
+        _node->m_color = _last_level ? _color::Red : _color::Black;
+    }
+
+    // AVL balancing
+    void rb_tree_avl::_insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept {
+        _node->m_rank = 1;
+        _retrace(_node->m_parent, _root, _nil);
+    }
+
+    void rb_tree_avl::_erase_fix_up(_base_ptr, _base_ptr, _base_ptr _parent, bool,
+                                    _base_ptr &_root, _base_ptr _nil) noexcept {
+        _retrace(_parent, _root, _nil);
+    }
+
+    void rb_tree_avl::_built(_base_ptr _node, bool, _base_ptr) noexcept {
+        _update_height(_node);
+    }
+
+    void rb_tree_avl::_retrace(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept {
+        while ( _node != _nil ) {
+            const int _old_height = _node->m_rank;
+            const int _balance    = _node->m_left->m_rank - _node->m_right->m_rank;
+            if ( _balance > 1 ) {
+                _base_ptr _child = _node->m_left;
+                if ( _child->m_left->m_rank < _child->m_right->m_rank ) {
+                    rb_tree_node_base::_rotate_left(_child, _root, _nil);
+                    _update_height(_child);
+                }
+                rb_tree_node_base::_rotate_right(_node, _root, _nil);
+                _update_height(_node);
+                _node = _node->m_parent;
+            } else if ( _balance < -1 ) {
+                _base_ptr _child = _node->m_right;
+                if ( _child->m_right->m_rank < _child->m_left->m_rank ) {
+                    rb_tree_node_base::_rotate_right(_child, _root, _nil);
+                    _update_height(_child);
+                }
+                rb_tree_node_base::_rotate_left(_node, _root, _nil);
+                _update_height(_node);
+                _node = _node->m_parent;
+            }
+            _update_height(_node);
+
+            if ( _node->m_rank == _old_height ) {
+                return ;
+            }
+            _node = _node->m_parent;
+        }
+    }
+
+    // Weak AVL balancing
+    void rb_tree_wavl::_insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept {
+        _node->m_rank = 1;
+        _base_ptr _parent = _node->m_parent;
+
+        // _node is a 0-child of _parent: promote while its sibling is a 1-child.
+        while ( _parent != _nil && _parent->m_rank == _node->m_rank ) {
+            const bool      _left    = _node == _parent->m_left;
+            const _base_ptr _sibling = _left ? _parent->m_right : _parent->m_left;
+            if ( _parent->m_rank - _sibling->m_rank == 1 ) {
+                ++_parent->m_rank;
+                _node   = _parent;
+                _parent = _node->m_parent;
+                continue;
+            }
+
+            // _parent is a 0,2 node: one or two rotations end the fix-up.
+            const _base_ptr _inner = _left ? _node->m_right : _node->m_left;
+            if ( _inner == _nil || _node->m_rank - _inner->m_rank == 2 ) {
+                if ( _left ) {
+                    rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                } else {
+                    rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                }
+                --_parent->m_rank;
+            } else {
+                if ( _left ) {
+                    rb_tree_node_base::_rotate_left(_node, _root, _nil);
+                    rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                } else {
+                    rb_tree_node_base::_rotate_right(_node, _root, _nil);
+                    rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                }
+                ++_inner->m_rank;
+                --_node->m_rank;
+                --_parent->m_rank;
+            }
+            return ;
+        }
+    }
+
+    void rb_tree_wavl::_erase_fix_up(_base_ptr, _base_ptr _child, _base_ptr _parent, bool _left,
+                                     _base_ptr &_root, _base_ptr _nil) noexcept {
+        if ( _parent == _nil ) {
+            return ;
+        }
+
+        // A parent left without children is a 2,2 leaf; leaves must have rank 0.
+        if ( _parent->m_left == _nil && _parent->m_right == _nil && _parent->m_rank == 2 ) {
+            _parent->m_rank = 1;
+            _child  = _parent;
+            _parent = _child->m_parent;
+            _left   = _parent != _nil && _child == _parent->m_left;
+        }
+
+        // _child is a 3-child of _parent: demote while possible, otherwise rotate.
+        while ( _parent != _nil && _parent->m_rank - _child->m_rank == 3 ) {
+            const _base_ptr _sibling = _left ? _parent->m_right : _parent->m_left;
+            if ( _parent->m_rank - _sibling->m_rank == 2 ) {
+                --_parent->m_rank;
+            } else if ( _sibling->m_rank - _sibling->m_left->m_rank == 2 &&
+                        _sibling->m_rank - _sibling->m_right->m_rank == 2 ) {
+                --_parent->m_rank;
+                --_sibling->m_rank;
+            } else {
+                const _base_ptr _outer = _left ? _sibling->m_right : _sibling->m_left;
+                const _base_ptr _inner = _left ? _sibling->m_left  : _sibling->m_right;
+                if ( _sibling->m_rank - _outer->m_rank == 1 ) {
+                    if ( _left ) {
+                        rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                    } else {
+                        rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                    }
+                    ++_sibling->m_rank;
+                    --_parent->m_rank;
+                    if ( _parent->m_left == _nil && _parent->m_right == _nil ) {
+                        --_parent->m_rank;
+                    }
+                } else {
+                    if ( _left ) {
+                        rb_tree_node_base::_rotate_right(_sibling, _root, _nil);
+                        rb_tree_node_base::_rotate_left(_parent, _root, _nil);
+                    } else {
+                        rb_tree_node_base::_rotate_left(_sibling, _root, _nil);
+                        rb_tree_node_base::_rotate_right(_parent, _root, _nil);
+                    }
+                    _inner->m_rank   += 2;
+                    _sibling->m_rank -= 1;
+                    _parent->m_rank  -= 2;
+                }
+                return ;
+            }
+
+            _child  = _parent;
+            _parent = _child->m_parent;
+            _left   = _parent != _nil && _child == _parent->m_left;
+        }
+    }
+
+    void rb_tree_wavl::_built(_base_ptr _node, bool, _base_ptr) noexcept {
+        _node->m_rank = _max_child_rank(_node) + 1;
+    }
+} // namespace cxx
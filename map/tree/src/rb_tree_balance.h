@@ -0,0 +1,66 @@
+#ifndef   RB_TREE_BALANCE_
+# define  RB_TREE_BALANCE_
+
+# include "rb_tree_node_base.h"  // For rb_tree_node_base
+
+namespace cxx {
+    /// @brief Balancing policies of `rb_tree`.
+    /// @details A policy restores the balance of the tree after the tree has linked in or
+    /// unlinked a node, using the rotations of `rb_tree_node_base`. Every policy provides:
+    /// - `_insert_fix_up(node, root, nil)`: `node` was just linked in as a leaf.
+    /// - `_erase_fix_up(removed, child, parent, left, root, nil)`: `removed`, which had at
+    ///   most one child, was unlinked and `child` (possibly nil) took its place as the
+    ///   left (`left == true`) or right child of `parent` (possibly nil). `removed` still
+    ///   carries its balance information.
+    /// - `_built(node, last_level, nil)`: `node` is the root of a perfectly balanced subtree
+    ///   whose children are already final (see `rb_tree::_merge_sorted()`); `last_level`
+    ///   tells whether it is on the incomplete deepest level.
+    /// Policies only differ in how shallow they keep the tree and how much work an update costs;
+    /// iteration and lookups do not depend on them.
+
+    /// @brief Red-black balancing: at most two rotations per insertion and three per erasure.
+    /// Paths are at most twice as long as the shortest one, i.e. height <= 2 log2(n + 1).
+    struct rb_tree_red_black {
+        using _base_ptr = rb_tree_node_base *;
+
+        static void _insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _erase_fix_up(_base_ptr _removed, _base_ptr _child, _base_ptr _parent, bool _left,
+                                  _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _built(_base_ptr _node, bool _last_level, _base_ptr _nil) noexcept;
+    };
+
+    /// @brief AVL balancing: the heights of sibling subtrees differ by at most one.
+    /// Trees stay shallower than red-black ones (height < 1.44 log2(n + 2)), which shortens
+    /// lookups, at the cost of more rotations on erasure and of retracing up to the root.
+    /// `m_rank` holds the height of the subtree (1 for a leaf, 0 for nil).
+    struct rb_tree_avl {
+        using _base_ptr = rb_tree_node_base *;
+
+        static void _insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _erase_fix_up(_base_ptr _removed, _base_ptr _child, _base_ptr _parent, bool _left,
+                                  _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _built(_base_ptr _node, bool _last_level, _base_ptr _nil) noexcept;
+
+    private:
+        /// @brief Recomputes heights from `_node` up to the root, rotating where a node is unbalanced.
+        /// Stops as soon as a subtree keeps its height.
+        static void _retrace(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
+    };
+
+    /// @brief Weak AVL (rank-balanced) balancing.
+    /// Every rank difference between a node and its child is 1 or 2 and leaves have rank 0.
+    /// Without erasures the tree is an AVL tree; erasures only demote ranks and need at most
+    /// two rotations, so updates cost about as little as red-black ones while lookups stay
+    /// at least as short (height <= 2 log2(n + 1), and < 1.44 log2(n + 2) without erasures).
+    /// `m_rank` holds the rank plus one, so that nil has 0 and a leaf 1.
+    struct rb_tree_wavl {
+        using _base_ptr = rb_tree_node_base *;
+
+        static void _insert_fix_up(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _erase_fix_up(_base_ptr _removed, _base_ptr _child, _base_ptr _parent, bool _left,
+                                  _base_ptr &_root, _base_ptr _nil) noexcept;
+        static void _built(_base_ptr _node, bool _last_level, _base_ptr _nil) noexcept;
+    };
+} // namespace cxx
+
+#endif // RB_TREE_BALANCE_
@@ -0,0 +1,251 @@
+#ifndef   RB_TREE_HASH_INDEX_
+# define  RB_TREE_HASH_INDEX_
+
+# include <bits/c++config.h>        // For std::size_t
+# include <bits/functional_hash.h>  // For std::hash
+# include <bits/stl_function.h>     // For std::equal_to, std::_Select1st
+
+# include "rb_tree_node.h"  // For rb_tree_node
+
+namespace cxx {
+    /// @brief Open-addressing hash index from keys to Red-Black Tree nodes.
+    /// This class maps the key of every indexed node to the node itself, so exact-key
+    /// lookups can skip the O(log n) descent through the tree. Collisions are resolved by
+    /// linear probing and removals use backward-shift deletion, so the table never holds
+    /// tombstones. Each slot caches the full hash of its key, so probing only dereferences
+    /// a node when the hashes match.
+    /// The index does not own the nodes; the owning tree must keep it in sync.
+    /// @tparam Key The type of keys used to look nodes up.
+    /// @tparam Val The type of elements stored in the indexed nodes.
+    /// @tparam Hash A hash function object for `Key`.
+    /// @tparam KeyEqual A binary predicate that checks two keys for equality.
+    /// @tparam Node The node type of the indexed tree (`rb_tree::node_type`).
+    template<
+        typename Key,
+        typename Val,
+        typename Hash     = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>,
+        typename Node     = rb_tree_node<Val>
+    >
+    class rb_tree_hash_index {
+        using _node_ptr = Node *;
+
+        /// @brief A single table entry; an empty slot has a null `m_node`.
+        struct _slot {
+            _node_ptr   m_node { nullptr }; ///< Indexed node, or `nullptr` if the slot is free.
+            std::size_t m_hash { 0 };       ///< Cached hash of the node's key.
+        };
+
+    public:
+        using key_type    = Key;
+        using value_type  = Val;
+        using hasher      = Hash;
+        using key_equal   = KeyEqual;
+        using size_type   = std::size_t;
+
+        explicit rb_tree_hash_index(const hasher &hash = hasher(), const key_equal &equal = key_equal())
+            : m_hash{hash}, m_equal{equal}, m_slots{nullptr}, m_capacity{0}, m_size{0}, m_shift{64} {
+        }
+
+        // The index holds pointers into one particular tree; the owner rebuilds it instead.
+        rb_tree_hash_index(const rb_tree_hash_index &) = delete;
+        rb_tree_hash_index &operator=(const rb_tree_hash_index &) = delete;
+
+        ~rb_tree_hash_index() {
+            delete[] m_slots;
+        }
+
+        /// @brief Returns the number of indexed nodes.
+        [[nodiscard]]
+        constexpr size_type size() const noexcept {
+            return m_size;
+        }
+
+        /// @brief Returns the hash function used by the index.
+        [[nodiscard]]
+        hasher hash_function() const {
+            return m_hash;
+        }
+
+        /// @brief Returns the key equality predicate used by the index.
+        [[nodiscard]]
+        key_equal key_eq() const {
+            return m_equal;
+        }
+
+        /// @brief Returns the number of slots in the table.
+        [[nodiscard]]
+        constexpr size_type capacity() const noexcept {
+            return m_capacity;
+        }
+
+        /// @brief Looks up the node holding the given key.
+        /// @param _key The key to search for.
+        /// @return Pointer to the node with that key, or `nullptr` if it is not indexed.
+        [[nodiscard]]
+        _node_ptr find(const key_type &_key) const;
+
+        /// @brief Adds a node to the index.
+        /// @param _node Pointer to the node to index. Its key must not be indexed yet.
+        void insert(_node_ptr _node);
+
+        /// @brief Removes the node with the given key from the index.
+        /// @param _key The key of the node to remove.
+        /// @return `true` if a node was removed, `false` if the key was not indexed.
+        bool erase(const key_type &_key);
+
+        /// @brief Grows the table so that `_count` nodes fit without rehashing.
+        /// @param _count The number of nodes to make room for.
+        void reserve(size_type _count);
+
+        /// @brief Removes every node from the index, keeping the allocated table.
+        void clear() noexcept;
+
+    private:
+        /// @brief Extracts the key from a node's value.
+        static const key_type &_key_of(const _node_ptr _node) {
+            return std::_Select1st<value_type>()(_node->m_valueField);
+        }
+
+        /// @brief Returns the home slot of a hash in the current table.
+        /// The hash is mixed with a Fibonacci multiply and the high bits are kept, so
+        /// identity hashes of strided keys (e.g. multiples of the capacity) still spread out.
+        constexpr size_type _home(const std::size_t _hash) const noexcept {
+            return static_cast<size_type>((static_cast<unsigned long long>(_hash) * 11400714819323198485ull) >> m_shift);
+        }
+
+        /// @brief Returns the slot probed after `_i`.
+        constexpr size_type _next_slot(const size_type _i) const noexcept {
+            return (_i + 1) & (m_capacity - 1);
+        }
+
+        /// @brief Places a node into the table without checking for growth.
+        void _place(_node_ptr _node, std::size_t _hash) noexcept;
+
+        /// @brief Reallocates the table with `_capacity` slots and reinserts every node.
+        /// @param _capacity The new number of slots; must be a power of two.
+        void _rehash(size_type _capacity);
+
+        hasher    m_hash;
+        key_equal m_equal;
+        _slot    *m_slots;
+        size_type m_capacity; ///< Number of slots; always zero or a power of two.
+        size_type m_size;
+        unsigned  m_shift;    ///< 64 - log2(m_capacity), the shift applied in `_home()`.
+    };
+} // namespace cxx
+
+// Hash index implementation
+namespace cxx {
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    Node *
+    rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::find(const key_type &_key) const {
+        if (m_size == 0) {
+            return nullptr;
+        }
+
+        const std::size_t _hash = m_hash(_key);
+        for (size_type _i = _home(_hash); m_slots[_i].m_node != nullptr; _i = _next_slot(_i)) {
+            if (m_slots[_i].m_hash == _hash && m_equal(_key_of(m_slots[_i].m_node), _key)) {
+                return m_slots[_i].m_node;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    void rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::insert(_node_ptr _node) {
+        // Keep the load factor at or below 1/2 so probe sequences stay short.
+        if ((m_size + 1) * 2 > m_capacity) {
+            _rehash(m_capacity == 0 ? 16 : m_capacity * 2);
+        }
+
+        _place(_node, m_hash(_key_of(_node)));
+        ++m_size;
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    bool rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::erase(const key_type &_key) {
+        if (m_size == 0) {
+            return false;
+        }
+
+        const std::size_t _hash = m_hash(_key);
+        size_type _i = _home(_hash);
+        while (m_slots[_i].m_node != nullptr &&
+               !(m_slots[_i].m_hash == _hash && m_equal(_key_of(m_slots[_i].m_node), _key))) {
+            _i = _next_slot(_i);
+        }
+
+        if (m_slots[_i].m_node == nullptr) {
+            return false;
+        }
+
+        // Backward-shift deletion: pull later entries of the cluster into the hole
+        // unless that would move them in front of their home slot.
+        for (size_type _j = _next_slot(_i); m_slots[_j].m_node != nullptr; _j = _next_slot(_j)) {
+            const size_type _k = _home(m_slots[_j].m_hash);
+            const bool _stays = (_i <= _j) ? (_i < _k && _k <= _j) : (_i < _k || _k <= _j);
+            if (!_stays) {
+                m_slots[_i] = m_slots[_j];
+                _i = _j;
+            }
+        }
+
+        m_slots[_i] = _slot{};
+        --m_size;
+        return true;
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    void rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::reserve(size_type _count) {
+        size_type _capacity = m_capacity == 0 ? 16 : m_capacity;
+        while (_count * 2 > _capacity) {
+            _capacity *= 2;
+        }
+
+        if (_capacity != m_capacity) {
+            _rehash(_capacity);
+        }
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    void rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::clear() noexcept {
+        for (size_type _i = 0; _i < m_capacity; ++_i) {
+            m_slots[_i] = _slot{};
+        }
+        m_size = 0;
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    void rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::_place(_node_ptr _node, std::size_t _hash) noexcept {
+        size_type _i = _home(_hash);
+        while (m_slots[_i].m_node != nullptr) {
+            _i = _next_slot(_i);
+        }
+
+        m_slots[_i].m_node = _node;
+        m_slots[_i].m_hash = _hash;
+    }
+
+    template<typename Key, typename Val, typename Hash, typename KeyEqual, typename Node>
+    void rb_tree_hash_index<Key, Val, Hash, KeyEqual, Node>::_rehash(size_type _capacity) {
+        _slot *const    _old          = m_slots;
+        const size_type _old_capacity = m_capacity;
+
+        m_slots    = new _slot[_capacity]{};
+        m_capacity = _capacity;
+        m_shift    = 64;
+        for (size_type _c = _capacity; _c > 1; _c >>= 1) {
+            --m_shift;
+        }
+        for (size_type _i = 0; _i < _old_capacity; ++_i) {
+            if (_old[_i].m_node != nullptr) {
+                _place(_old[_i].m_node, _old[_i].m_hash);
+            }
+        }
+        delete[] _old;
+    }
+} // namespace cxx
+
+#endif // RB_TREE_HASH_INDEX_
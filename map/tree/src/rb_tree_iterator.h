@@ -11,12 +11,12 @@ namespace cxx {
     /// @brief Iterator for red-black trees.
     /// This class provides an iterator for traversing red-black trees.
     /// It supports both read and write access to the elements of the tree.
-    template<typename T>
+    template<typename T, typename Node = rb_tree_node<T>>
     struct rb_tree_iterator {
     private:
         using _self                 = rb_tree_iterator;
         using _base_ptr             = rb_tree_node_base *;
-        using _node_ptr             = rb_tree_node<T> *;
+        using _node_ptr             = Node *;
 
     public:
         using value_type = T  ;
@@ -38,7 +38,7 @@ namespace cxx {
         /// @param _x   Pointer to the base node.
         /// @param _nil Pointer to the nil  node.
         constexpr explicit
-        rb_tree_iterator(_node_ptr _x, const _base_ptr const _nil)
+        rb_tree_iterator(_node_ptr _x, const _base_ptr _nil)
             : m_node{_x}, m_nil{_nil} {
         }
 
@@ -107,7 +107,7 @@ namespace cxx {
         operator!=(const _self &_x) const { return m_node != _x.m_node; }
 
         _base_ptr m_node;            ///< Pointer to the current node in the tree.
-        const _base_ptr const m_nil; ///< Pointer to the nil in the tree.
+        _base_ptr m_nil;             ///< Pointer to the nil in the tree.
     };
 } // namespace cxx
 
@@ -115,13 +115,13 @@ namespace cxx {
     /// @brief Const iterator for red-black trees.
     /// This class provides a const iterator for traversing red-black trees.
     /// It supports read-only access to the elements of the tree.
-    template<typename T>
+    template<typename T, typename Node = rb_tree_node<T>>
     struct rb_tree_const_iterator {
     private:
-        using _iterator       = rb_tree_iterator<T>;
+        using _iterator       = rb_tree_iterator<T, Node>;
         using _self           = rb_tree_const_iterator;
         using _base_ptr       = const rb_tree_node_base *;
-        using _node_ptr       = const rb_tree_node<T> *;
+        using _node_ptr       = const Node *;
 
     public:
         using value_type = T;
@@ -220,7 +220,7 @@ namespace cxx {
         operator!=(const _self &_x) const { return m_node != _x.m_node; }
 
         _base_ptr m_node;      ///< Pointer to the current node in the tree.
-        _base_ptr const m_nil; ///< Pointer to the nil node in the tree.
+        _base_ptr m_nil;       ///< Pointer to the nil node in the tree.
     };
 } // namespace cxx
 
@@ -0,0 +1,70 @@
+#ifndef   RB_TREE_KEY_PREFIX_
+# define  RB_TREE_KEY_PREFIX_
+
+# include <bits/c++config.h>     // For std::size_t
+# include <bits/char_traits.h>   // For std::char_traits
+# include <bits/stl_function.h>  // For std::less
+# include <bits/stringfwd.h>     // For std::basic_string
+# include <cstdint>              // For std::uint64_t
+
+# include "rb_tree_node.h"  // For rb_tree_node, rb_tree_prefixed_node
+
+namespace cxx {
+    /// @brief Key prefix policy of a Red-Black Tree.
+    /// @details The primary template disables prefix caching: nodes are plain
+    /// `rb_tree_node`s and every comparison goes through `Compare`.
+    /// A specialization enables it by providing:
+    /// - `enabled`     : `true`;
+    /// - `prefix_type` : an unsigned integer type;
+    /// - `make(key)`   : a prefix such that `make(a) < make(b)` implies `Compare()(a, b)`.
+    ///   Equal prefixes say nothing about the keys, so the tree then falls back to `Compare`.
+    /// Specialize it for other string-like keys to give them the same fast path.
+    /// @tparam Key The type of keys of the tree.
+    /// @tparam Compare The comparison the prefix has to agree with.
+    template<typename Key, typename Compare>
+    struct rb_tree_key_prefix {
+        static constexpr bool enabled = false;
+
+        template<typename Val>
+        using node_type = rb_tree_node<Val>;
+    };
+
+    /// @brief Prefix policy for byte strings ordered lexicographically.
+    /// @details The prefix is the first 8 bytes of the key read as a big-endian integer
+    /// and zero-padded, which orders exactly like `std::char_traits<char>::compare`
+    /// (it compares as `unsigned char`) on those 8 bytes.
+    struct rb_tree_string_prefix {
+        static constexpr bool enabled = true;
+
+        using prefix_type = std::uint64_t;
+
+        template<typename Val>
+        using node_type = rb_tree_prefixed_node<Val, rb_tree_string_prefix>;
+
+        /// @brief Returns the normalized 8-byte prefix of a string-like key.
+        /// @param _key Any key with `size()` and `operator[]` yielding `char`.
+        template<typename String>
+        static prefix_type make(const String &_key) noexcept {
+            const std::size_t _len = _key.size() < sizeof(prefix_type) ? _key.size() : sizeof(prefix_type);
+            prefix_type _prefix = 0;
+            for (std::size_t _i = 0; _i < _len; ++_i) {
+                _prefix |= static_cast<prefix_type>(static_cast<unsigned char>(_key[_i]))
+                           << (8 * (sizeof(prefix_type) - 1 - _i));
+            }
+            return _prefix;
+        }
+    };
+
+    template<typename Alloc>
+    struct rb_tree_key_prefix<std::basic_string<char, std::char_traits<char>, Alloc>,
+                              std::less<std::basic_string<char, std::char_traits<char>, Alloc>>>
+        : rb_tree_string_prefix {
+    };
+
+    template<typename Alloc>
+    struct rb_tree_key_prefix<std::basic_string<char, std::char_traits<char>, Alloc>, std::less<void>>
+        : rb_tree_string_prefix {
+    };
+} // namespace cxx
+
+#endif // RB_TREE_KEY_PREFIX_
@@ -1,6 +1,9 @@
 #ifndef   RB_TREE_NODE_
 # define  RB_TREE_NODE_
 
+# include <bits/move.h>          // For std::move
+# include <bits/stl_function.h>  // For std::_Select1st
+
 # include "rb_tree_node_base.h"  // For rb_tree_node_base
 
 namespace cxx {
@@ -18,6 +21,36 @@ namespace cxx {
         explicit rb_tree_node(const ValueType &_val)
             : rb_tree_node_base{}, m_valueField{_val} {
         }
+
+        /// @brief Constructs the node by moving the given value into it.
+        /// Used when an existing node is relocated (see `rb_tree::compact()`).
+        explicit rb_tree_node(ValueType &&_val)
+            : rb_tree_node_base{}, m_valueField{std::move(_val)} {
+        }
+    };
+
+    /// @brief class representing a red-black tree node that caches a key prefix.
+    /// @details The prefix is stored right after the links and before the value, so
+    /// comparisons that are decided by the prefix never touch the value (or any heap
+    /// buffer it owns). `Traits` computes the prefix from the key and defines its type;
+    /// see `rb_tree_key_prefix`.
+    template<typename ValueType, typename Traits>
+    struct rb_tree_prefixed_node : rb_tree_node_base {
+        using _node_ptr   = rb_tree_prefixed_node *;        ///< Pointer type for the node.
+        using prefix_type = typename Traits::prefix_type;  ///< Type of the cached prefix.
+
+        prefix_type m_prefix     { }; ///< Order-preserving prefix of the key.
+        ValueType   m_valueField { }; ///< The value stored in the node.
+
+        explicit rb_tree_prefixed_node(const ValueType &_val)
+            : rb_tree_node_base{}, m_prefix{Traits::make(std::_Select1st<ValueType>()(_val))}, m_valueField{_val} {
+        }
+
+        /// @brief Constructs the node by moving the given value into it.
+        /// The prefix is taken before the value is moved from.
+        explicit rb_tree_prefixed_node(ValueType &&_val)
+            : rb_tree_node_base{}, m_prefix{Traits::make(std::_Select1st<ValueType>()(_val))}, m_valueField{std::move(_val)} {
+        }
     };
 } // namespace cxx
 
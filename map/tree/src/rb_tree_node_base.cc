@@ -1,81 +1,24 @@
 #include "rb_tree_node_base.h"
 
 namespace cxx {
-    constexpr rb_tree_node_base *
-    rb_tree_node_base::_next(_base_ptr _x, const _base_ptr const _nil) noexcept {
-        if (_x->m_right != _nil) {
-            return _minimum(_x->m_right, _nil);
-        }
-
-        _base_ptr _y = _x->m_parent;
-        while (_x == _y->m_right) {
-            _x = _y;
-            _y = _y->m_parent;
-        }
-        return _y;
-    }
-
-    constexpr rb_tree_node_base *
-    rb_tree_node_base::_prev(_base_ptr _x, const _base_ptr const _nil) noexcept {
-        if (_x == _nil) {
-            _x = _nil->m_parent;
-            return _maximum(_x, _nil);
-        }
-
-        if (_x->m_left != _nil) {
-            return _maximum(_x->m_left, _nil);
-        }
-
-        _base_ptr _y = _x->m_parent;
-        while (_x == _y->m_left) {
-            _x = _y;
-            _y = _y->m_parent;
-        }
-        return _y;
-    }
-
-    constexpr rb_tree_node_base *
-    rb_tree_node_base::_minimum(_base_ptr _x, const _base_ptr const _nil) noexcept {
-        if (_x == _nil) {
-            return _x;
-        }
-
-        while (_x->m_left != _nil) {
-            _x = _x->m_left;
-        }
-        return _x;
-    }
-
-    constexpr rb_tree_node_base *
-    rb_tree_node_base::_maximum(_base_ptr _x, const _base_ptr const _nil) noexcept {
-        if (_x == _nil) {
-            return _x;
-        }
-
-        while (_x->m_right != _nil) {
-            _x = _x->m_right;
-        }
-        return _x;
-    }
-
     const rb_tree_node_base *
-    rb_tree_node_base::_minimum(const _base_ptr _x, const _base_ptr const _nil) noexcept {
-        return _minimum(const_cast<_base_ptr>(_x), _nil);
+    rb_tree_node_base::_minimum(_ptr_const_base _x, _ptr_const_base _nil) noexcept {
+        return _minimum(const_cast<_base_ptr>(_x), const_cast<_base_ptr>(_nil));
     }
 
     const rb_tree_node_base *
-    rb_tree_node_base::_maximum(const _base_ptr _x, const _base_ptr const _nil) noexcept {
-        return _maximum(const_cast<_base_ptr>(_x), _nil);
+    rb_tree_node_base::_maximum(_ptr_const_base _x, _ptr_const_base _nil) noexcept {
+        return _maximum(const_cast<_base_ptr>(_x), const_cast<_base_ptr>(_nil));
     }
 
     const rb_tree_node_base *
-    rb_tree_node_base::_next(const _base_ptr _x, const _base_ptr const _nil) noexcept {
-        return _next(const_cast<_base_ptr>(_x), _nil);
+    rb_tree_node_base::_next(_ptr_const_base _x, _ptr_const_base _nil) noexcept {
+        return _next(const_cast<_base_ptr>(_x), const_cast<_base_ptr>(_nil));
     }
 
     const rb_tree_node_base *
-    rb_tree_node_base::_prev(const _base_ptr _x, const _base_ptr const _nil) noexcept {
-        return _prev(const_cast<_base_ptr>(_x), _nil);
+    rb_tree_node_base::_prev(_ptr_const_base _x, _ptr_const_base _nil) noexcept {
+        return _prev(const_cast<_base_ptr>(_x), const_cast<_base_ptr>(_nil));
     }
 
     void rb_tree_node_base::_resolve_red_uncle(_base_ptr _parent, _base_ptr _uncle) noexcept
@@ -90,4 +33,48 @@ namespace cxx {
         _parent->m_color = _color::Black;
         _parent->m_parent->m_color = _color::Red;
     }
+
+    void rb_tree_node_base::_rotate_left(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept
+    {
+        _base_ptr _child = _node->m_right;
+
+        _node->m_right = _child->m_left;
+        if ( _child->m_left != _nil ) {
+            _child->m_left->m_parent = _node;
+        }
+
+        _child->m_parent = _node->m_parent;
+        if ( _node->m_parent == _nil ) {
+            _root = _child;
+        } else if ( _node == _node->m_parent->m_left ) {
+            _node->m_parent->m_left = _child;
+        } else {
+            _node->m_parent->m_right = _child;
+        }
+
+        _child->m_left  = _node;
+        _node->m_parent = _child;
+    }
+
+    void rb_tree_node_base::_rotate_right(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept
+    {
+        _base_ptr _child = _node->m_left;
+
+        _node->m_left = _child->m_right;
+        if ( _child->m_right != _nil ) {
+            _child->m_right->m_parent = _node;
+        }
+
+        _child->m_parent = _node->m_parent;
+        if ( _node->m_parent == _nil ) {
+            _root = _child;
+        } else if ( _node == _node->m_parent->m_right ) {
+            _node->m_parent->m_right = _child;
+        } else {
+            _node->m_parent->m_left = _child;
+        }
+
+        _child->m_right = _node;
+        _node->m_parent = _child;
+    }
 }
@@ -13,64 +13,67 @@ namespace cxx {
 
     /// @brief Base class for red-black tree nodes.
     /// @details This class defines the basic structure of a node in a red-black tree.
-    /// It includes pointers to the parent, left child, right child, and the color of the node.
+    /// It includes pointers to the parent, left child, right child, and the balance information
+    /// of the node: its color for red-black balancing, its rank for rank-balanced policies.
     /// This class is intended to be used as a base class for more specific node types.
     struct rb_tree_node_base {
         using _color                = rb_tree_node_color ;
         using _base_ptr             = rb_tree_node_base *;
+        using _ptr_const_base       = const rb_tree_node_base *;
 
         _base_ptr m_parent { nullptr };     ///< Pointer to the parent node.
         _base_ptr m_left   { nullptr };     ///< Pointer to the left child node.
         _base_ptr m_right  { nullptr };     ///< Pointer to the right child node.
         _color    m_color  { _color::Red }; ///< Color of the node (red or black).
+        int       m_rank   { 0 };           ///< Rank of the node for AVL / weak-AVL balancing; 0 for nil.
 
         /// @brief Minimum node in the subtree.
         /// @param _x Pointer to the node from which to find the minimum.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Pointer to the minimum node in the subtree rooted at `_x`.
-        constexpr static _base_ptr _minimum(_base_ptr _x, const _base_ptr const _nil) noexcept;
+        constexpr static _base_ptr _minimum(_base_ptr _x, const _base_ptr _nil) noexcept;
 
         /// @brief Maximum node in the subtree.
         /// @param _x Pointer to the node from which to find the maximum.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Pointer to the maximum node in the subtree rooted at `_x`.
-        constexpr static _base_ptr _maximum(_base_ptr _x, const _base_ptr const _nil) noexcept;
+        constexpr static _base_ptr _maximum(_base_ptr _x, const _base_ptr _nil) noexcept;
 
         /// @brief Minimum node in the subtree (const version).
         /// @param _x Const pointer to the node from which to find the minimum.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Const pointer to the minimum node in the subtree rooted at `_x`.
-        static _ptr_const_base _minimum(_ptr_const_base _x, const _base_ptr const _nil) noexcept;
+        static _ptr_const_base _minimum(_ptr_const_base _x, _ptr_const_base _nil) noexcept;
 
         /// @brief Maximum node in the subtree (const version).
         /// @param _x Const pointer to the node from which to find the maximum.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Const pointer to the maximum node in the subtree rooted at `_x`.
-        static _ptr_const_base _maximum(_ptr_const_base _x, const _base_ptr const _nil) noexcept;
+        static _ptr_const_base _maximum(_ptr_const_base _x, _ptr_const_base _nil) noexcept;
 
         /// @brief Get the next node in the in-order traversal.
         /// @param _x   Pointer to the current node.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Pointer to the next node in the in-order traversal.
-        constexpr static _base_ptr _next(_base_ptr _x, const _base_ptr const _nil) noexcept;
+        constexpr static _base_ptr _next(_base_ptr _x, const _base_ptr _nil) noexcept;
 
         /// @brief Get the previous node in the in-order traversal.
         /// @param _x Pointer to the current node.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Pointer to the previous node in the in-order traversal.
-        constexpr static _base_ptr _prev(_base_ptr _x, const _base_ptr const _nil) noexcept;
+        constexpr static _base_ptr _prev(_base_ptr _x, const _base_ptr _nil) noexcept;
 
         /// @brief Get the next node in the in-order traversal (const version).
         /// @param _x Const pointer to the current node.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Const pointer to the next node in the in-order traversal.
-        static _ptr_const_base _next(_ptr_const_base _x, const _base_ptr const _nil) noexcept;
+        static _ptr_const_base _next(_ptr_const_base _x, _ptr_const_base _nil) noexcept;
 
         /// @brief Get the previous node in the in-order traversal (const version).
         /// @param _x Const pointer to the current node.
         /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
         /// @return Const pointer to the previous node in the in-order traversal.
-        static _ptr_const_base _prev(_ptr_const_base _x, const _base_ptr const _nil) noexcept;
+        static _ptr_const_base _prev(_ptr_const_base _x, _ptr_const_base _nil) noexcept;
 
         /// @brief Resolves the red-uncle case in Red-Black Tree insertion.
         ///
@@ -94,7 +97,83 @@ namespace cxx {
         /// @note This function assumes the uncle is black or null and that the grandparent exists.
         /// @see _insertFixUp()
         static void _resolve_red_parent(_base_ptr _parent) noexcept;
+
+        /// @brief Rotates the subtree rooted at `_node` to the left.
+        /// The right child of `_node` takes its place and `_node` becomes its left child.
+        /// @param _node Pointer to the node to rotate; its right child must not be nil.
+        /// @param _root Root of the tree, updated if `_node` was the root.
+        /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
+        static void _rotate_left(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
+
+        /// @brief Rotates the subtree rooted at `_node` to the right.
+        /// The left child of `_node` takes its place and `_node` becomes its right child.
+        /// @param _node Pointer to the node to rotate; its left child must not be nil.
+        /// @param _root Root of the tree, updated if `_node` was the root.
+        /// @param _nil Sentinel node representing leaf/null in the Red-Black Tree.
+        static void _rotate_right(_base_ptr _node, _base_ptr &_root, _base_ptr _nil) noexcept;
     };
 }
 
+// Red-Black Tree node base implementation of the constexpr helpers.
+// They are defined here rather than in rb_tree_node_base.cc so that every
+// translation unit instantiating rb_tree can see (and constant-evaluate) them.
+namespace cxx {
+    constexpr rb_tree_node_base *
+    rb_tree_node_base::_next(_base_ptr _x, const _base_ptr _nil) noexcept {
+        if (_x->m_right != _nil) {
+            return _minimum(_x->m_right, _nil);
+        }
+
+        _base_ptr _y = _x->m_parent;
+        while (_x == _y->m_right) {
+            _x = _y;
+            _y = _y->m_parent;
+        }
+        return _y;
+    }
+
+    constexpr rb_tree_node_base *
+    rb_tree_node_base::_prev(_base_ptr _x, const _base_ptr _nil) noexcept {
+        if (_x == _nil) {
+            _x = _nil->m_parent;
+            return _maximum(_x, _nil);
+        }
+
+        if (_x->m_left != _nil) {
+            return _maximum(_x->m_left, _nil);
+        }
+
+        _base_ptr _y = _x->m_parent;
+        while (_x == _y->m_left) {
+            _x = _y;
+            _y = _y->m_parent;
+        }
+        return _y;
+    }
+
+    constexpr rb_tree_node_base *
+    rb_tree_node_base::_minimum(_base_ptr _x, const _base_ptr _nil) noexcept {
+        if (_x == _nil) {
+            return _x;
+        }
+
+        while (_x->m_left != _nil) {
+            _x = _x->m_left;
+        }
+        return _x;
+    }
+
+    constexpr rb_tree_node_base *
+    rb_tree_node_base::_maximum(_base_ptr _x, const _base_ptr _nil) noexcept {
+        if (_x == _nil) {
+            return _x;
+        }
+
+        while (_x->m_right != _nil) {
+            _x = _x->m_right;
+        }
+        return _x;
+    }
+} // namespace cxx
+
 #endif // RB_TREE_NODE_BASE_
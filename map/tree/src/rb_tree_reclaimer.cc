@@ -0,0 +1,101 @@
+#include "rb_tree_reclaimer.h"
+
+#include <bits/stl_function.h>  // For std::less
+
+namespace cxx {
+    rb_tree_garbage::~rb_tree_garbage() {
+        while (!done()) {
+            reclaim(static_cast<std::size_t>(-1));
+        }
+
+        if (m_owns_nil) {
+            delete m_nil;
+        }
+        ::operator delete(m_pool);
+    }
+
+    std::size_t rb_tree_garbage::reclaim(std::size_t _budget) noexcept {
+        const std::less<const void *> _before;
+        std::size_t _steps = 0;
+        while (m_root != m_nil && _steps < _budget) {
+            const _base_ptr _left = m_root->m_left;
+            if (_left != m_nil) {
+                // Rotate right so the left child becomes the root; parent links are dead.
+                m_root->m_left = _left->m_right;
+                _left->m_right = m_root;
+                m_root = _left;
+            } else {
+                const _base_ptr _right  = m_root->m_right;
+                const bool      _pooled = m_pool != nullptr &&
+                                          !_before(m_root, m_pool) && _before(m_root, m_pool_end);
+                m_destroy(m_root, _pooled);
+                m_root = _right;
+            }
+            ++_steps;
+        }
+        return _steps;
+    }
+
+    rb_tree_reclaimer &rb_tree_reclaimer::instance() {
+        static rb_tree_reclaimer _reclaimer;
+        return _reclaimer;
+    }
+
+    rb_tree_reclaimer::rb_tree_reclaimer()
+        : m_queue{nullptr}, m_busy{false}, m_stop{false} {
+        m_thread = std::thread{&rb_tree_reclaimer::_run, this};
+    }
+
+    rb_tree_reclaimer::~rb_tree_reclaimer() {
+        {
+            std::lock_guard<std::mutex> _lock{m_mutex};
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    void rb_tree_reclaimer::push(rb_tree_garbage *_garbage) {
+        rb_tree_garbage *_last = _garbage;
+        while (_last->m_next != nullptr) {
+            _last = _last->m_next;
+        }
+
+        {
+            std::lock_guard<std::mutex> _lock{m_mutex};
+            _last->m_next = m_queue;
+            m_queue = _garbage;
+        }
+        m_wake.notify_one();
+    }
+
+    void rb_tree_reclaimer::drain() {
+        std::unique_lock<std::mutex> _lock{m_mutex};
+        m_idle.wait(_lock, [this] { return m_queue == nullptr && !m_busy; });
+    }
+
+    void rb_tree_reclaimer::_run() {
+        std::unique_lock<std::mutex> _lock{m_mutex};
+        for (;;) {
+            m_wake.wait(_lock, [this] { return m_queue != nullptr || m_stop; });
+            if (m_queue == nullptr) {
+                return ; // Stopping and nothing left to destroy.
+            }
+
+            rb_tree_garbage *_batch = m_queue;
+            m_queue = nullptr;
+            m_busy  = true;
+            _lock.unlock();
+            while (_batch != nullptr) {
+                rb_tree_garbage *const _next = _batch->m_next;
+                delete _batch;
+                _batch = _next;
+            }
+            _lock.lock();
+            m_busy = false;
+            if (m_queue == nullptr) {
+                m_idle.notify_all();
+            }
+        }
+    }
+} // namespace cxx
@@ -0,0 +1,120 @@
+#ifndef   RB_TREE_RECLAIMER_
+# define  RB_TREE_RECLAIMER_
+
+# include <bits/c++config.h>     // For std::size_t
+# include <condition_variable>   // For std::condition_variable
+# include <mutex>                // For std::mutex
+# include <thread>               // For std::thread
+
+# include "rb_tree_node_base.h"  // For rb_tree_node_base
+
+namespace cxx {
+    /// @brief Enum class selecting how a Red-Black Tree frees the nodes it lets go of.
+    /// @details This enum class defines when the nodes dropped by `clear()`, assignment and
+    /// the destructor are destroyed:
+    /// - `Immediate`  : right away, in the calling thread.
+    /// - `Incremental`: `clear()` detaches the nodes in O(1) and later operations on the
+    ///                  same tree destroy a bounded number of them each. The destructor
+    ///                  hands whatever is left to `rb_tree_reclaimer`, like `Background`.
+    /// - `Background` : `clear()` and the destructor detach the nodes in O(1) and hand them
+    ///                  to `rb_tree_reclaimer`, whose thread destroys them. Element destructors
+    ///                  then run on that thread.
+    enum class rb_tree_reclaim {
+        Immediate,   ///< Destroy nodes in the calling thread.
+        Incremental, ///< Destroy a bounded number of nodes per later operation.
+        Background   ///< Destroy nodes on the reclaimer thread.
+    };
+
+    /// @brief A detached Red-Black Tree waiting to be destroyed.
+    /// @details The nodes are destroyed without recursion by rotating every left child up
+    /// until the root has none, then deleting the root and continuing with its right
+    /// subtree. Each rotation and each deletion is one step, so a tree of n nodes takes
+    /// at most 2n steps and no extra memory, whatever its shape.
+    /// The node type is erased: the owning tree passes a function that destroys one node.
+    class rb_tree_garbage {
+        using _base_ptr = rb_tree_node_base *;
+
+    public:
+        /// @brief Destroys a single node; `_pooled` is true if it lives in the garbage's pool.
+        using destroy_fn = void (*)(_base_ptr _node, bool _pooled) noexcept;
+
+        /// @param _root Root of the detached tree.
+        /// @param _nil Sentinel of the detached tree.
+        /// @param _owns_nil Whether the garbage deletes `_nil` once it is done.
+        /// @param _pool Node block the tree allocated with `::operator new`, or `nullptr`.
+        /// @param _pool_bytes Size of `_pool` in bytes.
+        /// @param _destroy Function destroying one node.
+        rb_tree_garbage(_base_ptr _root, _base_ptr _nil, bool _owns_nil,
+                        void *_pool, std::size_t _pool_bytes, destroy_fn _destroy) noexcept
+            : m_next{nullptr}, m_root{_root}, m_nil{_nil}, m_owns_nil{_owns_nil},
+              m_pool{_pool}, m_pool_end{static_cast<char *>(_pool) + _pool_bytes}, m_destroy{_destroy} {
+        }
+
+        rb_tree_garbage(const rb_tree_garbage &) = delete;
+        rb_tree_garbage &operator=(const rb_tree_garbage &) = delete;
+
+        /// @brief Destroys every node that is left, then the sentinel and the pool.
+        ~rb_tree_garbage();
+
+        /// @brief Performs at most `_budget` destruction steps.
+        /// @param _budget Maximum number of rotations and deletions to perform.
+        /// @return The number of steps performed; less than `_budget` only once the tree is gone.
+        std::size_t reclaim(std::size_t _budget) noexcept;
+
+        /// @brief Checks whether every node has been destroyed.
+        [[nodiscard]]
+        bool done() const noexcept {
+            return m_root == m_nil;
+        }
+
+        rb_tree_garbage *m_next; ///< Next entry in the list the garbage is queued in.
+
+    private:
+        _base_ptr   m_root;
+        _base_ptr   m_nil;
+        bool        m_owns_nil;
+        void       *m_pool;
+        const void *m_pool_end;
+        destroy_fn  m_destroy;
+    };
+
+    /// @brief Process-wide thread that destroys detached Red-Black Trees.
+    /// @details Trees using `rb_tree_reclaim::Background` push their garbage here and return
+    /// at once; so do `rb_tree_reclaim::Incremental` trees when they are destroyed. The thread is started by the first such tree; since that tree obtains the
+    /// reclaimer in its constructor, the reclaimer outlives every tree that uses it, including
+    /// trees with static storage duration. On destruction the reclaimer finishes all queued work.
+    class rb_tree_reclaimer {
+    public:
+        /// @brief Returns the process-wide reclaimer, starting its thread on first use.
+        static rb_tree_reclaimer &instance();
+
+        rb_tree_reclaimer(const rb_tree_reclaimer &) = delete;
+        rb_tree_reclaimer &operator=(const rb_tree_reclaimer &) = delete;
+
+        ~rb_tree_reclaimer();
+
+        /// @brief Queues detached trees for destruction and takes ownership of them.
+        /// @param _garbage First of a list of garbage allocated with `new` and linked through
+        ///                 `m_next`; the list is destroyed in order.
+        void push(rb_tree_garbage *_garbage);
+
+        /// @brief Blocks until everything pushed so far has been destroyed.
+        void drain();
+
+    private:
+        rb_tree_reclaimer();
+
+        /// @brief Body of the reclaimer thread.
+        void _run();
+
+        std::mutex              m_mutex;
+        std::condition_variable m_wake;  ///< Signalled when work is queued or on shutdown.
+        std::condition_variable m_idle;  ///< Signalled when the queue has been emptied.
+        rb_tree_garbage        *m_queue; ///< Garbage waiting for the thread.
+        bool                    m_busy;  ///< Whether the thread is destroying a batch.
+        bool                    m_stop;
+        std::thread             m_thread;
+    };
+} // namespace cxx
+
+#endif // RB_TREE_RECLAIMER_